@@ -25,6 +25,7 @@
 #include <PICo24/Peripherals/EXT_INT/EXT_INT.h>
 #include <PICo24/Peripherals/Timer/Timer.h>
 #include <PICo24/Peripherals/USB/usb_deluxe.h>
+#include <PICo24/Core/Latency.h>
 
 #ifdef PICo24_Enable_Peripheral_TIMER
 
@@ -114,6 +115,51 @@ const UART_HandleTypeDef huart3 = {
 	.TXREG = &U3TXREG,
 	.RXREG = &U3RXREG
 };
+
+void __attribute__((interrupt,auto_psv)) _U1RXInterrupt() {
+	_U1RXIF = 0;
+	UART_ProcessRxInterrupt(&huart1);
+}
+
+void __attribute__((interrupt,auto_psv)) _U1TXInterrupt() {
+	_U1TXIF = 0;
+	UART_ProcessTxInterrupt(&huart1);
+}
+
+void __attribute__((interrupt,auto_psv)) _U1ErrInterrupt() {
+	_U1ERIF = 0;
+	UART_ProcessErrInterrupt(&huart1);
+}
+
+void __attribute__((interrupt,auto_psv)) _U2RXInterrupt() {
+	_U2RXIF = 0;
+	UART_ProcessRxInterrupt(&huart2);
+}
+
+void __attribute__((interrupt,auto_psv)) _U2TXInterrupt() {
+	_U2TXIF = 0;
+	UART_ProcessTxInterrupt(&huart2);
+}
+
+void __attribute__((interrupt,auto_psv)) _U2ErrInterrupt() {
+	_U2ERIF = 0;
+	UART_ProcessErrInterrupt(&huart2);
+}
+
+void __attribute__((interrupt,auto_psv)) _U3RXInterrupt() {
+	_U3RXIF = 0;
+	UART_ProcessRxInterrupt(&huart3);
+}
+
+void __attribute__((interrupt,auto_psv)) _U3TXInterrupt() {
+	_U3TXIF = 0;
+	UART_ProcessTxInterrupt(&huart3);
+}
+
+void __attribute__((interrupt,auto_psv)) _U3ErrInterrupt() {
+	_U3ERIF = 0;
+	UART_ProcessErrInterrupt(&huart3);
+}
 #endif
 
 #ifdef PICo24_Enable_Peripheral_SPI
@@ -251,15 +297,21 @@ I2C_HandleTypeDef hi2c3 = {
 };
 
 void __attribute__ ((interrupt, no_auto_psv)) _MI2C1Interrupt() {
+	PICo24_LATENCY_ENTER(LATENCY_ISR_I2C);
 	I2C_Master_ProcessInterrupt(&hi2c1);
+	PICo24_LATENCY_EXIT(LATENCY_ISR_I2C);
 }
 
 void __attribute__ ((interrupt, no_auto_psv)) _MI2C2Interrupt() {
+	PICo24_LATENCY_ENTER(LATENCY_ISR_I2C);
 	I2C_Master_ProcessInterrupt(&hi2c2);
+	PICo24_LATENCY_EXIT(LATENCY_ISR_I2C);
 }
 
 void __attribute__ ((interrupt, no_auto_psv)) _MI2C3Interrupt() {
+	PICo24_LATENCY_ENTER(LATENCY_ISR_I2C);
 	I2C_Master_ProcessInterrupt(&hi2c3);
+	PICo24_LATENCY_EXIT(LATENCY_ISR_I2C);
 }
 #endif
 
@@ -268,11 +320,18 @@ void __attribute__ ((interrupt, no_auto_psv)) _MI2C3Interrupt() {
 void __attribute__((interrupt,auto_psv)) _USB1Interrupt() {
 	if (usb_deluxe_role == USB_ROLE_DEVICE) {
 #ifdef PICo24_Enable_Peripheral_USB_DEVICE
+		PICo24_LATENCY_ENTER(LATENCY_ISR_USB);
 		USBDeviceTasks();
+		PICo24_LATENCY_EXIT(LATENCY_ISR_USB);
+#ifdef PICo24_FreeRTOS_Enabled
+		USBDeluxe_Device_YieldFromISR();
+#endif
 #endif
 	} else if (usb_deluxe_role == USB_ROLE_HOST) {
 #ifdef PICo24_Enable_Peripheral_USB_HOST
+		PICo24_LATENCY_ENTER(LATENCY_ISR_USB);
 		USB_HostInterruptHandler();
+		PICo24_LATENCY_EXIT(LATENCY_ISR_USB);
 #endif
 	} else {
 		USBClearUSBInterrupt();
@@ -24,7 +24,9 @@
 #include <PICo24/Peripherals/I2C/I2C.h>
 #include <PICo24/Peripherals/EXT_INT/EXT_INT.h>
 #include <PICo24/Peripherals/Timer/Timer.h>
+#include <PICo24/Peripherals/DMA/DMA.h>
 #include <PICo24/Peripherals/USB/usb_deluxe.h>
+#include <PICo24/Core/Latency.h>
 
 #ifdef PICo24_Enable_Peripheral_TIMER
 
@@ -139,7 +141,9 @@ const UART_HandleTypeDef huart1 = {
 	.MODE = (volatile UARTMODEBITS *) &U1MODE,
 	.BRG = &U1BRG,
 	.TXREG = &U1TXREG,
-	.RXREG = &U1RXREG
+	.RXREG = &U1RXREG,
+	.DMA_RX_TRIGGER = 11,
+	.DMA_TX_TRIGGER = 12
 };
 
 const UART_HandleTypeDef huart2 = {
@@ -147,7 +151,9 @@ const UART_HandleTypeDef huart2 = {
 	.MODE = (volatile UARTMODEBITS *) &U2MODE,
 	.BRG = &U2BRG,
 	.TXREG = &U2TXREG,
-	.RXREG = &U2RXREG
+	.RXREG = &U2RXREG,
+	.DMA_RX_TRIGGER = 30,
+	.DMA_TX_TRIGGER = 31
 };
 
 const UART_HandleTypeDef huart3 = {
@@ -155,8 +161,55 @@ const UART_HandleTypeDef huart3 = {
 	.MODE = (volatile UARTMODEBITS *) &U3MODE,
 	.BRG = &U3BRG,
 	.TXREG = &U3TXREG,
-	.RXREG = &U3RXREG
+	.RXREG = &U3RXREG,
+	.DMA_RX_TRIGGER = 82,
+	.DMA_TX_TRIGGER = 83
 };
+
+void __attribute__((interrupt,auto_psv)) _U1RXInterrupt() {
+	_U1RXIF = 0;
+	UART_ProcessRxInterrupt(&huart1);
+}
+
+void __attribute__((interrupt,auto_psv)) _U1TXInterrupt() {
+	_U1TXIF = 0;
+	UART_ProcessTxInterrupt(&huart1);
+}
+
+void __attribute__((interrupt,auto_psv)) _U1ErrInterrupt() {
+	_U1ERIF = 0;
+	UART_ProcessErrInterrupt(&huart1);
+}
+
+void __attribute__((interrupt,auto_psv)) _U2RXInterrupt() {
+	_U2RXIF = 0;
+	UART_ProcessRxInterrupt(&huart2);
+}
+
+void __attribute__((interrupt,auto_psv)) _U2TXInterrupt() {
+	_U2TXIF = 0;
+	UART_ProcessTxInterrupt(&huart2);
+}
+
+void __attribute__((interrupt,auto_psv)) _U2ErrInterrupt() {
+	_U2ERIF = 0;
+	UART_ProcessErrInterrupt(&huart2);
+}
+
+void __attribute__((interrupt,auto_psv)) _U3RXInterrupt() {
+	_U3RXIF = 0;
+	UART_ProcessRxInterrupt(&huart3);
+}
+
+void __attribute__((interrupt,auto_psv)) _U3TXInterrupt() {
+	_U3TXIF = 0;
+	UART_ProcessTxInterrupt(&huart3);
+}
+
+void __attribute__((interrupt,auto_psv)) _U3ErrInterrupt() {
+	_U3ERIF = 0;
+	UART_ProcessErrInterrupt(&huart3);
+}
 #endif
 
 #ifdef PICo24_Enable_Peripheral_SPI
@@ -164,14 +217,16 @@ const SPI_HandleTypeDef hspi1 = {
 	.STAT = (SPISTATBITS *) &SPI1STAT,
 	.CON1 = (SPICON1BITS *) &SPI1CON1,
 	.CON2 = (SPICON1BITS *) &SPI1CON2,
-	.BUF = &SPI1BUF
+	.BUF = &SPI1BUF,
+	.DMA_TRIGGER = 10
 };
 
 const SPI_HandleTypeDef hspi2 = {
 	.STAT = (SPISTATBITS *) &SPI2STAT,
 	.CON1 = (SPICON1BITS *) &SPI2CON1,
 	.CON2 = (SPICON1BITS *) &SPI2CON2,
-	.BUF = &SPI2BUF
+	.BUF = &SPI2BUF,
+	.DMA_TRIGGER = 33
 };
 
 
@@ -179,10 +234,89 @@ const SPI_HandleTypeDef hspi3 = {
 	.STAT = (SPISTATBITS *) &SPI3STAT,
 	.CON1 = (SPICON1BITS *) &SPI3CON1,
 	.CON2 = (SPICON1BITS *) &SPI3CON2,
-	.BUF = &SPI3BUF
+	.BUF = &SPI3BUF,
+	.DMA_TRIGGER = 91
 };
 #endif
 
+#ifdef PICo24_Enable_Peripheral_DMA
+// The trigger numbers in the UART and SPI handles above are their IRQ numbers
+const DMA_HandleTypeDef hdma[PICo24_DMA_Channels] = {
+	{
+		.CH = (volatile DMACHBITS *) &DMACH0,
+		.INT = (volatile DMAINTBITS *) &DMAINT0,
+		.SRC = &DMASRC0,
+		.DST = &DMADST0,
+		.CNT = &DMACNT0
+	},
+	{
+		.CH = (volatile DMACHBITS *) &DMACH1,
+		.INT = (volatile DMAINTBITS *) &DMAINT1,
+		.SRC = &DMASRC1,
+		.DST = &DMADST1,
+		.CNT = &DMACNT1
+	},
+	{
+		.CH = (volatile DMACHBITS *) &DMACH2,
+		.INT = (volatile DMAINTBITS *) &DMAINT2,
+		.SRC = &DMASRC2,
+		.DST = &DMADST2,
+		.CNT = &DMACNT2
+	},
+	{
+		.CH = (volatile DMACHBITS *) &DMACH3,
+		.INT = (volatile DMAINTBITS *) &DMAINT3,
+		.SRC = &DMASRC3,
+		.DST = &DMADST3,
+		.CNT = &DMACNT3
+	},
+	{
+		.CH = (volatile DMACHBITS *) &DMACH4,
+		.INT = (volatile DMAINTBITS *) &DMAINT4,
+		.SRC = &DMASRC4,
+		.DST = &DMADST4,
+		.CNT = &DMACNT4
+	},
+	{
+		.CH = (volatile DMACHBITS *) &DMACH5,
+		.INT = (volatile DMAINTBITS *) &DMAINT5,
+		.SRC = &DMASRC5,
+		.DST = &DMADST5,
+		.CNT = &DMACNT5
+	}
+};
+
+void __attribute__((interrupt,auto_psv)) _DMA0Interrupt() {
+	_DMA0IF = 0;
+	DMA_ProcessInterrupt(0);
+}
+
+void __attribute__((interrupt,auto_psv)) _DMA1Interrupt() {
+	_DMA1IF = 0;
+	DMA_ProcessInterrupt(1);
+}
+
+void __attribute__((interrupt,auto_psv)) _DMA2Interrupt() {
+	_DMA2IF = 0;
+	DMA_ProcessInterrupt(2);
+}
+
+void __attribute__((interrupt,auto_psv)) _DMA3Interrupt() {
+	_DMA3IF = 0;
+	DMA_ProcessInterrupt(3);
+}
+
+void __attribute__((interrupt,auto_psv)) _DMA4Interrupt() {
+	_DMA4IF = 0;
+	DMA_ProcessInterrupt(4);
+}
+
+void __attribute__((interrupt,auto_psv)) _DMA5Interrupt() {
+	_DMA5IF = 0;
+	DMA_ProcessInterrupt(5);
+}
+#endif
+
 
 #ifdef PICo24_Enable_Peripheral_EXTINT
 EXTINT_HandleTypeDef hextint0 = {
@@ -302,15 +436,21 @@ I2C_HandleTypeDef hi2c3 = {
 };
 
 void __attribute__ ((interrupt,auto_psv)) _MI2C1Interrupt() {
+	PICo24_LATENCY_ENTER(LATENCY_ISR_I2C);
 	I2C_Master_ProcessInterrupt(&hi2c1);
+	PICo24_LATENCY_EXIT(LATENCY_ISR_I2C);
 }
 
 void __attribute__ ((interrupt,auto_psv)) _MI2C2Interrupt() {
+	PICo24_LATENCY_ENTER(LATENCY_ISR_I2C);
 	I2C_Master_ProcessInterrupt(&hi2c2);
+	PICo24_LATENCY_EXIT(LATENCY_ISR_I2C);
 }
 
 void __attribute__ ((interrupt,auto_psv)) _MI2C3Interrupt() {
+	PICo24_LATENCY_ENTER(LATENCY_ISR_I2C);
 	I2C_Master_ProcessInterrupt(&hi2c3);
+	PICo24_LATENCY_EXIT(LATENCY_ISR_I2C);
 }
 
 #endif
@@ -321,11 +461,18 @@ void __attribute__((interrupt,auto_psv)) _USB1Interrupt() {
 
 	if (usb_deluxe_role == USB_ROLE_DEVICE) {
 #ifdef PICo24_Enable_Peripheral_USB_DEVICE
+		PICo24_LATENCY_ENTER(LATENCY_ISR_USB);
 		USBDeviceTasks();
+		PICo24_LATENCY_EXIT(LATENCY_ISR_USB);
+#ifdef PICo24_FreeRTOS_Enabled
+		USBDeluxe_Device_YieldFromISR();
+#endif
 #endif
 	} else if (usb_deluxe_role == USB_ROLE_HOST) {
 #ifdef PICo24_Enable_Peripheral_USB_HOST
+		PICo24_LATENCY_ENTER(LATENCY_ISR_USB);
 		USB_HostInterruptHandler();
+		PICo24_LATENCY_EXIT(LATENCY_ISR_USB);
 #endif
 	} else {
 		USBClearUSBInterrupt();
@@ -115,9 +115,39 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay			1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
+#define INCLUDE_xTaskGetSchedulerState		1
+#define INCLUDE_xTaskGetIdleTaskHandle		1
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
 
 
 #define configKERNEL_INTERRUPT_PRIORITY	0x01
+/* Run time stats, see PICo24/Core/FreeRTOS_Support.c */
+#define configGENERATE_RUN_TIME_STATS		1
+
+// Has to be at least the number of tasks, or uxTaskGetSystemState() gives up
+#define PICo24_TaskStats_MaxTasks		16
+
+extern void PICo24_RunTimeCounter_Initialize(void);
+extern uint32_t PICo24_RunTimeCounter(void);
+extern volatile uint16_t PICo24_TaskStats_Switches[PICo24_TaskStats_MaxTasks + 1];
+extern void PICo24_TaskCreated(void *handle, uint16_t number, const char *name, uint16_t stack_size);
+extern void PICo24_TaskDeleted(uint16_t number);
+
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	PICo24_RunTimeCounter_Initialize()
+#define portGET_RUN_TIME_COUNTER_VALUE()		PICo24_RunTimeCounter()
+
+/* Event trace, see PICo24/Core/Trace.c */
+#include <PICo24/Core/Trace.h>
+#include <PICo24/Core/Latency.h>
+
+/* The stack grows up on this port, so the size is known from pxEndOfStack */
+#define traceTASK_CREATE(pxNewTCB)			PICo24_TaskCreated((pxNewTCB), (pxNewTCB)->uxTCBNumber, (pxNewTCB)->pcTaskName, (pxNewTCB)->pxEndOfStack - (pxNewTCB)->pxStack + 1)
+#define traceTASK_DELETE(pxTaskToDelete)		PICo24_TaskDeleted((pxTaskToDelete)->uxTCBNumber)
+/* A critical section open across a switch would span the time the task is blocked, see PICo24/Core/Latency.h */
+#define traceTASK_SWITCHED_OUT()			PICo24_LATENCY_ABORT(LATENCY_CRITICAL)
+#define traceTASK_SWITCHED_IN()				do { if (pxCurrentTCB->uxTCBNumber <= PICo24_TaskStats_MaxTasks) PICo24_TaskStats_Switches[pxCurrentTCB->uxTCBNumber]++; PICo24_TRACE(TRACE_EV_TASK_SWITCH, pxCurrentTCB->uxTCBNumber, 0); } while (0)
+
 #define pdMS_TO_TICKS( xTimeInMs ) ( ( TickType_t) ( ( ( TickType_t) ( xTimeInMs ) )) * ((( TickType_t) configTICK_RATE_HZ ) / ( TickType_t) 1000 ))
 
 #endif /* FREERTOS_CONFIG_H */
@@ -4,11 +4,21 @@
 
 #include <stdio.h>
 
+#include <ScratchLibc/ScratchLibc.h>
+
 void vApplicationIdleHook( void )
 {
 	printf("idle\n");
 	/* Schedule the co-routines from within the idle task hook. */
 	vCoRoutineSchedule();
+
+	/* Check a few heap blocks at a time, see umm_malloc_cfg.h */
+#if UMM_INTEGRITY_IDLE_STEP_BLOCKS
+	umm_integrity_step(UMM_INTEGRITY_IDLE_STEP_BLOCKS);
+#endif
+#if defined(__HAS_EDS__) && UMM_EDS_INTEGRITY_IDLE_STEP_BLOCKS
+	umm_eds_integrity_step(UMM_EDS_INTEGRITY_IDLE_STEP_BLOCKS);
+#endif
 }
 /*-----------------------------------------------------------*/
 
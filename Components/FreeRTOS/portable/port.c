@@ -81,6 +81,8 @@
 #include "../FreeRTOS.h"
 #include "../task.h"
 
+#include <PICo24/Core/Latency.h>
+
 /* Hardware specifics. */
 #define portBIT_SET 1
 #define portTIMER_PRESCALE 8
@@ -383,7 +385,10 @@ __attribute__(( weak )) void vApplicationSetupTickTimerInterrupt() {
 void vPortEnterCritical( void )
 {
 	portDISABLE_INTERRUPTS();
-	uxCriticalNesting++;
+	if( uxCriticalNesting++ == 0 )
+	{
+		PICo24_LATENCY_ENTER( LATENCY_CRITICAL );
+	}
 }
 /*-----------------------------------------------------------*/
 
@@ -393,6 +398,7 @@ void vPortExitCritical( void )
 	uxCriticalNesting--;
 	if( uxCriticalNesting == 0 )
 	{
+		PICo24_LATENCY_EXIT( LATENCY_CRITICAL );
 		portENABLE_INTERRUPTS();
 	}
 }
@@ -403,9 +409,17 @@ void __attribute__((__interrupt__, auto_psv)) configTICK_INTERRUPT_HANDLER( void
 	/* Clear the timer interrupt. */
 	IFS0bits.T1IF = 0;
 
+	PICo24_LATENCY_ENTER( LATENCY_ISR_TICK );
+
 	if( xTaskIncrementTick() != pdFALSE )
 	{
+		/* Not counting the time spent in the other task. */
+		PICo24_LATENCY_EXIT( LATENCY_ISR_TICK );
 		portYIELD();
 	}
+	else
+	{
+		PICo24_LATENCY_EXIT( LATENCY_ISR_TICK );
+	}
 }
 
@@ -0,0 +1,216 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Deferred.h"
+
+#ifdef PICo24_FreeRTOS_Enabled
+
+#include <xc.h>
+
+#define DEFERRED_MASK		(PICo24_Deferred_QueueSize - 1)
+
+#if PICo24_Deferred_QueueSize & DEFERRED_MASK
+#error PICo24_Deferred_QueueSize must be a power of 2
+#endif
+
+typedef struct {
+	Deferred_Func func;
+	void *arg;
+	uint32_t stamp;
+} Deferred_Item;
+
+// Producers claim `head' with interrupts masked, only the worker touches `tail'
+typedef struct {
+	Deferred_Item items[PICo24_Deferred_QueueSize];
+	volatile uint16_t head;
+	volatile uint16_t tail;
+	TaskHandle_t worker;
+
+	uint32_t posted;
+	uint32_t run;
+	uint16_t dropped;
+	uint16_t depth_max;
+
+	// In run time counter units
+	uint32_t latency_last;
+	uint32_t latency_max;
+	uint32_t run_max;
+} Deferred_Queue;
+
+static Deferred_Queue deferred_queues[DEFERRED_LEVELS];
+
+static void Deferred_Worker(void *p) {
+	Deferred_Queue *q = p;
+
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		while (q->tail != q->head) {
+			Deferred_Item item = q->items[q->tail & DEFERRED_MASK];
+
+			// The slot is free for producers once tail moves
+			__asm__ __volatile__("" ::: "memory");
+			q->tail++;
+
+			uint32_t start = PICo24_RunTimeStamp();
+			item.func(item.arg);
+			uint32_t end = PICo24_RunTimeStamp();
+
+			uint32_t latency = PICo24_RunTimeElapsed(item.stamp, start);
+			uint32_t took = PICo24_RunTimeElapsed(start, end);
+
+			taskENTER_CRITICAL();
+			q->run++;
+			q->latency_last = latency;
+			if (latency > q->latency_max) {
+				q->latency_max = latency;
+			}
+			if (took > q->run_max) {
+				q->run_max = took;
+			}
+			taskEXIT_CRITICAL();
+		}
+	}
+}
+
+// Software triggered from Deferred_Post(), runs at the kernel priority
+void __attribute__((interrupt,auto_psv)) _CRCInterrupt() {
+	BaseType_t woken = pdFALSE;
+
+	// Cleared first, a post while scanning triggers another round
+	_CRCIF = 0;
+
+	for (uint8_t i=0; i<DEFERRED_LEVELS; i++) {
+		Deferred_Queue *q = &deferred_queues[i];
+
+		if (q->worker && q->head != q->tail) {
+			vTaskNotifyGiveFromISR(q->worker, &woken);
+		}
+	}
+
+	if (woken && freertos_started) {
+		taskYIELD();
+	}
+}
+
+bool Deferred_Initialize() {
+	static const UBaseType_t priorities[DEFERRED_LEVELS] = {PICo24_Deferred_HighPriority, PICo24_Deferred_LowPriority};
+	static const char *names[DEFERRED_LEVELS] = {"Deferred H", "Deferred L"};
+
+	for (uint8_t i=0; i<DEFERRED_LEVELS; i++) {
+		Deferred_Queue *q = &deferred_queues[i];
+
+		if (!q->worker) {
+			if (xTaskCreate(Deferred_Worker, names[i], PICo24_Deferred_StackSize, q, priorities[i], &q->worker) != pdPASS) {
+				return false;
+			}
+		}
+	}
+
+	// Anything posted before now is picked up as soon as this is enabled
+	_CRCIP = configKERNEL_INTERRUPT_PRIORITY;
+	_CRCIE = 1;
+
+	return true;
+}
+
+bool Deferred_Post(Deferred_Level level, Deferred_Func func, void *arg) {
+	Deferred_Queue *q = &deferred_queues[level];
+	uint32_t stamp = PICo24_RunTimeStamp();
+	bool ret = false;
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	uint16_t used = q->head - q->tail;
+
+	if (used < PICo24_Deferred_QueueSize) {
+		Deferred_Item *item = &q->items[q->head & DEFERRED_MASK];
+
+		item->func = func;
+		item->arg = arg;
+		item->stamp = stamp;
+		q->head++;
+
+		q->posted++;
+		if (used >= q->depth_max) {
+			q->depth_max = used + 1;
+		}
+
+		ret = true;
+	} else {
+		q->dropped++;
+	}
+
+	RESTORE_CPU_IPL(ipl);
+
+	if (ret) {
+		_CRCIF = 1;
+	}
+
+	return ret;
+}
+
+bool Deferred_GetStats(Deferred_Level level, Deferred_Stats *stats) {
+	if (level >= DEFERRED_LEVELS) {
+		return false;
+	}
+
+	Deferred_Queue *q = &deferred_queues[level];
+	uint32_t latency_last, latency_max, run_max;
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	stats->posted = q->posted;
+	stats->run = q->run;
+	stats->dropped = q->dropped;
+	stats->depth = q->head - q->tail;
+	stats->depth_max = q->depth_max;
+	latency_last = q->latency_last;
+	latency_max = q->latency_max;
+	run_max = q->run_max;
+	RESTORE_CPU_IPL(ipl);
+
+	stats->latency_last_us = PICo24_RunTimeToMicroseconds(latency_last);
+	stats->latency_max_us = PICo24_RunTimeToMicroseconds(latency_max);
+	stats->run_max_us = PICo24_RunTimeToMicroseconds(run_max);
+
+	return true;
+}
+
+void Deferred_ResetStats(Deferred_Level level) {
+	if (level >= DEFERRED_LEVELS) {
+		return;
+	}
+
+	Deferred_Queue *q = &deferred_queues[level];
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	q->posted = 0;
+	q->run = 0;
+	q->dropped = 0;
+	q->depth_max = q->head - q->tail;
+	q->latency_last = 0;
+	q->latency_max = 0;
+	q->run_max = 0;
+	RESTORE_CPU_IPL(ipl);
+}
+
+#endif
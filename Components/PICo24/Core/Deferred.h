@@ -0,0 +1,84 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS_Support.h"
+
+#ifdef PICo24_FreeRTOS_Enabled
+
+/*
+ * Deferred interrupt work. An ISR of any priority posts a function and an
+ * argument, and a worker task runs it later with interrupts enabled and the
+ * scheduler free to preempt it. There is one worker per level, DEFERRED_HIGH
+ * runs above every normal task, DEFERRED_LOW below the USB function tasks.
+ *
+ * Posting masks interrupts for a handful of instructions while the slot is
+ * claimed. ISRs above the kernel priority can't call FreeRTOS, so the workers
+ * are woken through a software triggered interrupt at the kernel priority,
+ * borrowed from the CRC module. Don't enable CRC interrupts yourself.
+ */
+
+#ifndef PICo24_Deferred_QueueSize
+#define PICo24_Deferred_QueueSize		16	// Per level, power of 2
+#endif
+
+#ifndef PICo24_Deferred_StackSize
+#define PICo24_Deferred_StackSize		256
+#endif
+
+#ifndef PICo24_Deferred_HighPriority
+#define PICo24_Deferred_HighPriority		(configMAX_PRIORITIES - 1)
+#endif
+
+#ifndef PICo24_Deferred_LowPriority
+#define PICo24_Deferred_LowPriority		2
+#endif
+
+typedef enum {
+	DEFERRED_HIGH = 0,
+	DEFERRED_LOW,
+	DEFERRED_LEVELS
+} Deferred_Level;
+
+typedef void (*Deferred_Func)(void *arg);
+
+typedef struct {
+	uint32_t posted;
+	uint32_t run;
+	uint16_t dropped;		// Queue was full
+	uint16_t depth;			// Right now
+	uint16_t depth_max;
+	uint32_t latency_last_us;	// Post to the item starting
+	uint32_t latency_max_us;
+	uint32_t run_max_us;		// Longest item
+} Deferred_Stats;
+
+extern bool Deferred_Initialize();
+
+// Safe from any ISR and from tasks. Returns false if the queue is full
+extern bool Deferred_Post(Deferred_Level level, Deferred_Func func, void *arg);
+
+extern bool Deferred_GetStats(Deferred_Level level, Deferred_Stats *stats);
+extern void Deferred_ResetStats(Deferred_Level level);
+
+#endif
\ No newline at end of file
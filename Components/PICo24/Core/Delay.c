@@ -20,21 +20,133 @@
 #include "Delay.h"
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS_Support.h"
+
+#if PICo24_Delay_Stats
+static Delay_Stats delay_stats;
+
+#define DELAY_STATS(x)		x
+#else
+#define DELAY_STATS(x)
+#endif
+
+// __delay32() in chunks of at most a second, so the cycle counts fit in 32 bits
+static void Delay_SpinMilliseconds(uint64_t milliseconds) {
+	DELAY_STATS(delay_stats.spin_us += milliseconds * 1000);
+
+	while (milliseconds) {
+		uint16_t n = milliseconds > 1000 ? 1000 : milliseconds;
+
+		__delay32(FCY_DIV_1000 * n);
+		milliseconds -= n;
+	}
+}
+
+static void Delay_SpinMicroseconds(uint64_t microseconds) {
+	DELAY_STATS(delay_stats.spin_us += microseconds);
+
+	while (microseconds) {
+		uint32_t n = microseconds > 1000000 ? 1000000 : microseconds;
+
+		__delay32((uint32_t)FCY_DIV_1000000 * n);
+		microseconds -= n;
+	}
+}
+
+#ifdef PICo24_FreeRTOS_Enabled
+
+#define DELAY_US_PER_TICK	(1000000UL / configTICK_RATE_HZ)
+#define DELAY_MAX_TICKS		(portMAX_DELAY / 2)
+
+// Tasks run at IPL 0, anything above that is an ISR or a critical section
+static bool Delay_CanBlock() {
+	return freertos_started && SRbits.IPL == 0 && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+// Tick count and the position of the tick timer (Timer 1) within that tick
+static void Delay_Now(TickType_t *tick, uint16_t *count) {
+	TickType_t t;
+
+	do {
+		t = xTaskGetTickCount();
+		*count = TMR1;
+	} while (t != xTaskGetTickCount());
+
+	*tick = t;
+}
+
+/*
+ * Blocks in vTaskDelayUntil() for the whole ticks, then busy waits on the
+ * tick timer's counter for what's left, so the wait is as precise as the
+ * timer (0.5us at 16 MIPS) and only the last partial tick is spent spinning.
+ */
+static void Delay_Block(uint64_t microseconds) {
+	const uint16_t period = PR1 + 1;
+	TickType_t tick, now_tick;
+	uint16_t count, now_count;
+
+	Delay_Now(&tick, &count);
+
+	uint64_t ticks = microseconds / DELAY_US_PER_TICK;
+	uint32_t total = count + (uint32_t)(microseconds % DELAY_US_PER_TICK) * period / DELAY_US_PER_TICK;
+	uint16_t target = total % period;
+
+	ticks += total / period;
+
+	// After blocking the spin starts at the beginning of a tick, otherwise where we are now
+	DELAY_STATS(delay_stats.spin_us += (uint32_t)(ticks ? target : target - count) * DELAY_US_PER_TICK / period);
+	DELAY_STATS(delay_stats.blocked_ticks += ticks);
+
+	while (ticks) {
+		TickType_t n = ticks > DELAY_MAX_TICKS ? DELAY_MAX_TICKS : ticks;
+
+		vTaskDelayUntil(&tick, n);
+		ticks -= n;
+	}
+
+	do {
+		Delay_Now(&now_tick, &now_count);
+	} while (now_tick == tick && now_count < target);
+}
+
+#endif
 
 void Delay_Milliseconds(uint64_t milliseconds) {
-    while (milliseconds--) {
-	    __delay32(FCY_DIV_1000);
-    }
+	DELAY_STATS(delay_stats.calls++);
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (Delay_CanBlock()) {
+		Delay_Block(milliseconds * 1000);
+		return;
+	}
+#endif
+
+	Delay_SpinMilliseconds(milliseconds);
 }
 
 void Delay_Microseconds(uint64_t microseconds) {
-    while (microseconds >= 32) {
-	    __delay32(FCY_DIV_1000000 * 32);
+	DELAY_STATS(delay_stats.calls++);
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (Delay_CanBlock()) {
+		Delay_Block(microseconds);
+		return;
+	}
+#endif
+
+	Delay_SpinMicroseconds(microseconds);
+}
+
+#if PICo24_Delay_Stats
+void Delay_GetStats(Delay_Stats *stats) {
+	*stats = delay_stats;
+}
 
-	    microseconds -= 32;
-    }
-    
-    while (microseconds--) {
-	    __delay32(FCY_DIV_1000000);
-    }
+void Delay_ResetStats() {
+	delay_stats.calls = 0;
+	delay_stats.blocked_ticks = 0;
+	delay_stats.spin_us = 0;
 }
+#endif
@@ -31,5 +31,28 @@ extern const uint32_t FCY;
 extern const uint32_t FCY_DIV_1000;
 extern const uint16_t FCY_DIV_1000000;
 
+/*
+ * When called from a task with the scheduler running, the delays block in
+ * vTaskDelayUntil() and only busy wait for the part that's shorter than a
+ * tick. Before the scheduler starts, in ISRs and in critical sections they
+ * spin.
+ */
+
 extern void Delay_Milliseconds(uint64_t milliseconds);
 extern void Delay_Microseconds(uint64_t microseconds);
+
+// How much CPU time the delays actually burn, compare spin_us with the total requested time
+#ifndef PICo24_Delay_Stats
+#define PICo24_Delay_Stats	1
+#endif
+
+#if PICo24_Delay_Stats
+typedef struct {
+	uint32_t calls;
+	uint32_t blocked_ticks;
+	uint64_t spin_us;
+} Delay_Stats;
+
+extern void Delay_GetStats(Delay_Stats *stats);
+extern void Delay_ResetStats();
+#endif
@@ -1,2 +1,183 @@
 #include "FreeRTOS_Support.h"
 
+#ifdef PICo24_FreeRTOS_Enabled
+
+#include <stdio.h>
+
+#include <PICo24/UnixAPI/mini_stdio.h>
+
+#include "Trace.h"
+#include "Delay.h"
+
+#ifndef PICo24_TaskStats_DumpStackSize
+#define PICo24_TaskStats_DumpStackSize	384
+#endif
+
+volatile uint16_t PICo24_TaskStats_Switches[PICo24_TaskStats_MaxTasks + 1];
+PICo24_TaskStack PICo24_TaskStacks[PICo24_TaskStats_MaxTasks + 1];
+
+// Indexed by the TCB number, which starts at 1
+static uint32_t taskstats_last_runtime[PICo24_TaskStats_MaxTasks + 1];
+static uint16_t taskstats_last_switches[PICo24_TaskStats_MaxTasks + 1];
+static uint32_t taskstats_last_total;
+static TaskStatus_t taskstats_status[PICo24_TaskStats_MaxTasks];
+
+static int taskstats_dump_fd;
+static TickType_t taskstats_dump_period;
+
+static uint32_t runtime_last;
+
+// traceTASK_CREATE, from within xTaskCreate()
+void PICo24_TaskCreated(void *handle, uint16_t number, const char *name, uint16_t stack_size) {
+	if (number <= PICo24_TaskStats_MaxTasks) {
+		PICo24_TaskStacks[number].handle = handle;
+		PICo24_TaskStacks[number].size = stack_size;
+	}
+
+#ifdef PICo24_Trace_Enabled
+	Trace_TaskCreated(number, name);
+#endif
+}
+
+// traceTASK_DELETE, from within vTaskDelete() with the kernel's interrupt mask. The TCB is freed right after.
+void PICo24_TaskDeleted(uint16_t number) {
+	if (number <= PICo24_TaskStats_MaxTasks) {
+		PICo24_TaskStacks[number].handle = NULL;
+		PICo24_TaskStacks[number].size = 0;
+	}
+
+#ifdef PICo24_Trace_Enabled
+	Trace_TaskDeleted(number);
+#endif
+}
+
+void PICo24_RunTimeCounter_Initialize() {
+	runtime_last = 0;
+}
+
+uint32_t PICo24_RunTimeStamp() {
+	TickType_t tick;
+	uint16_t count;
+
+	do {
+		tick = xTaskGetTickCountFromISR();
+		count = TMR1;
+	} while (tick != xTaskGetTickCountFromISR());
+
+	return tick * (uint32_t)(PR1 + 1) + count;
+}
+
+uint32_t PICo24_RunTimeToMicroseconds(uint32_t counts) {
+	return counts / FCY_DIV_1000000 * PICo24_RunTime_CyclesPerCount +
+		counts % FCY_DIV_1000000 * PICo24_RunTime_CyclesPerCount / FCY_DIV_1000000;
+}
+
+// Called on every context switch, possibly from the tick ISR
+uint32_t PICo24_RunTimeCounter() {
+	uint32_t now = PICo24_RunTimeStamp();
+
+	// Timer 1 wrapped but the tick hasn't been counted yet, don't go backwards
+	if ((int32_t)(now - runtime_last) > 0) {
+		runtime_last = now;
+	}
+
+	return runtime_last;
+}
+
+// Not reentrant, the window state is shared
+uint8_t PICo24_TaskStats_Sample(PICo24_TaskStats *stats, uint8_t max, uint16_t *load_permille) {
+	uint32_t total;
+	UBaseType_t n = uxTaskGetSystemState(taskstats_status, PICo24_TaskStats_MaxTasks, &total);
+	TaskHandle_t idle = xTaskGetIdleTaskHandle();
+	uint32_t window = (total - taskstats_last_total) / 1000;
+	uint8_t ret = 0;
+
+	taskstats_last_total = total;
+
+	if (load_permille) {
+		*load_permille = 0;
+	}
+
+	for (UBaseType_t i=0; i<n; i++) {
+		TaskStatus_t *s = &taskstats_status[i];
+		UBaseType_t num = s->xTaskNumber;
+		uint32_t runtime = 0;
+		uint16_t switches = 0;
+
+		if (num <= PICo24_TaskStats_MaxTasks) {
+			runtime = s->ulRunTimeCounter - taskstats_last_runtime[num];
+			switches = PICo24_TaskStats_Switches[num] - taskstats_last_switches[num];
+
+			taskstats_last_runtime[num] = s->ulRunTimeCounter;
+			taskstats_last_switches[num] = PICo24_TaskStats_Switches[num];
+		}
+
+		uint16_t permille = window ? runtime / window : 0;
+
+		if (permille > 1000) {
+			permille = 1000;
+		}
+
+		if (load_permille && s->xHandle == idle) {
+			*load_permille = 1000 - permille;
+		}
+
+		if (ret < max) {
+			PICo24_TaskStats *t = &stats[ret++];
+
+			t->handle = s->xHandle;
+			t->name = s->pcTaskName;
+			t->state = s->eCurrentState;
+			t->priority = s->uxCurrentPriority;
+			t->cpu_permille = permille;
+			t->switches = switches;
+			t->stack_free_min = s->usStackHighWaterMark;
+			t->stack_size = num <= PICo24_TaskStats_MaxTasks ? PICo24_TaskStacks[num].size : 0;
+		}
+	}
+
+	return ret;
+}
+
+void PICo24_TaskStats_Print(int fd) {
+	static const char states[] = {'X', 'R', 'B', 'S', 'D'};
+	PICo24_TaskStats stats[PICo24_TaskStats_MaxTasks];
+	uint16_t load;
+	uint8_t n = PICo24_TaskStats_Sample(stats, PICo24_TaskStats_MaxTasks, &load);
+
+	dprintf(fd, "%-16s %6s %7s %6s %6s %4s %s\n", "Task", "CPU%", "Sw", "Stack", "Size", "Prio", "State");
+
+	for (uint8_t i=0; i<n; i++) {
+		PICo24_TaskStats *t = &stats[i];
+
+		dprintf(fd, "%-16s %4u.%u %7u %6u %6u %4u %c\n", t->name, t->cpu_permille / 10, t->cpu_permille % 10,
+			t->switches, t->stack_free_min, t->stack_size, t->priority, t->state <= eDeleted ? states[t->state] : '?');
+	}
+
+	dprintf(fd, "CPU load: %u.%u%%\n", load / 10, load % 10);
+}
+
+static void PICo24_TaskStats_DumpTask(void *userp) {
+	TickType_t last = xTaskGetTickCount();
+
+	PICo24_TaskStats_Sample(NULL, 0, NULL);
+
+	while (1) {
+		vTaskDelayUntil(&last, taskstats_dump_period);
+		PICo24_TaskStats_Print(taskstats_dump_fd);
+	}
+}
+
+// The dump period is also the length of the window
+bool PICo24_TaskStats_StartDump(int fd, uint32_t period_ms) {
+	taskstats_dump_fd = fd;
+	taskstats_dump_period = period_ms / portTICK_PERIOD_MS;
+
+	if (!taskstats_dump_period) {
+		taskstats_dump_period = 1;
+	}
+
+	return xTaskCreate(PICo24_TaskStats_DumpTask, "TaskStats", PICo24_TaskStats_DumpStackSize, NULL, 1, NULL) == pdPASS;
+}
+
+#endif
@@ -7,7 +7,61 @@ extern int freertos_started;
 #include <FreeRTOS/FreeRTOS.h>
 #include <FreeRTOS/task.h>
 
+#include <stdbool.h>
+
 #define PICo24_YIELD()		if (freertos_started) taskYIELD()
+
+/*
+ * Per task statistics. Every PICo24_TaskStats_Sample() reports the CPU share
+ * and the number of times each task was switched in since the previous call,
+ * so calling it periodically gives a sliding window of that length. The stack
+ * figures are the smallest amount of free stack ever seen and the size, in words.
+ *
+ * The run time counter is Timer 1 (the tick timer) extended by the tick count,
+ * so it needs no extra timer and has a resolution of 8 cycles.
+ *
+ * PICo24_RunTimeStamp() is the raw value on the same scale. It writes no state
+ * so any ISR may take it, but Timer 1 may wrap before its tick is counted, so a
+ * stamp can be up to a tick early. Compare stamps with PICo24_RunTimeElapsed().
+ */
+
+// Prescale of Timer 1, set up by vApplicationSetupTickTimerInterrupt() in portable/port.c
+#define PICo24_RunTime_CyclesPerCount	8
+
+typedef struct {
+	TaskHandle_t handle;
+	const char *name;
+	eTaskState state;
+	UBaseType_t priority;
+	uint16_t cpu_permille;
+	uint16_t switches;
+	uint16_t stack_free_min;
+	uint16_t stack_size;
+} PICo24_TaskStats;
+
+// Indexed by the TCB number, filled in as tasks are created and cleared as they are deleted.
+// Only dereference the handle with the scheduler suspended.
+typedef struct {
+	TaskHandle_t handle;
+	uint16_t size;		// In words
+} PICo24_TaskStack;
+
+extern PICo24_TaskStack PICo24_TaskStacks[PICo24_TaskStats_MaxTasks + 1];
+
+extern uint32_t PICo24_RunTimeStamp();
+extern uint32_t PICo24_RunTimeToMicroseconds(uint32_t counts);
+
+// 0 if `to' is a stamp taken early, see above
+static inline uint32_t PICo24_RunTimeElapsed(uint32_t from, uint32_t to) {
+	int32_t d = to - from;
+
+	return d > 0 ? d : 0;
+}
+
+extern uint8_t PICo24_TaskStats_Sample(PICo24_TaskStats *stats, uint8_t max, uint16_t *load_permille);
+extern void PICo24_TaskStats_Print(int fd);
+extern bool PICo24_TaskStats_StartDump(int fd, uint32_t period_ms);
+
 #else
 #define PICo24_YIELD()
 #endif
\ No newline at end of file
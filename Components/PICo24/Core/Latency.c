@@ -0,0 +1,191 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Latency.h"
+
+#ifdef PICo24_Latency_Enabled
+
+#ifndef PICo24_Enable_Peripheral_TIMER
+#error The Latency feature needs the TIMER peripheral for the Timebase
+#endif
+
+#include <xc.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <PICo24/UnixAPI/mini_stdio.h>
+
+#include "Timebase.h"
+#include "Delay.h"
+
+typedef struct {
+	uint32_t start;
+	uint8_t depth;
+
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint32_t hist[PICo24_Latency_HistBins];
+} Latency_Source;
+
+static Latency_Source latency_sources[LATENCY_SOURCES];
+
+static const char *latency_names[LATENCY_USER] = {
+	"Critical", "Heap lock", "USB mask", "Tick ISR", "USB ISR", "I2C ISR"
+};
+
+static inline uint8_t Latency_Bin(uint32_t cycles) {
+	uint8_t bin = 0;
+
+	while (cycles >= 32 && bin < PICo24_Latency_HistBins - 1) {
+		cycles >>= 1;
+		bin++;
+	}
+
+	return bin;
+}
+
+// Both are called with the kernel's interrupt mask or from ISRs, so mask everything while touching the
+// counters. The few cycles spent here are part of what gets measured.
+void Latency_Enter(uint8_t source) {
+	Latency_Source *s = &latency_sources[source];
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	if (!s->depth++) {
+		s->start = PICo24_CycleStamp();
+	}
+
+	RESTORE_CPU_IPL(ipl);
+}
+
+void Latency_Exit(uint8_t source) {
+	Latency_Source *s = &latency_sources[source];
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	uint32_t now = PICo24_CycleStamp();
+
+	if (s->depth && !--s->depth) {
+		uint32_t d = now - s->start;
+
+		if (!s->count || d < s->min) {
+			s->min = d;
+		}
+
+		if (d > s->max) {
+			s->max = d;
+		}
+
+		s->count++;
+		s->total += d;
+		s->hist[Latency_Bin(d)]++;
+	}
+
+	RESTORE_CPU_IPL(ipl);
+}
+
+// No sample is taken, the matching exit finds depth at 0 and does nothing
+void Latency_Abort(uint8_t source) {
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	latency_sources[source].depth = 0;
+	RESTORE_CPU_IPL(ipl);
+}
+
+bool Latency_Get(uint8_t source, Latency_Stats *stats) {
+	if (source >= LATENCY_SOURCES) {
+		return false;
+	}
+
+	Latency_Source *s = &latency_sources[source];
+	uint64_t total;
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	stats->count = s->count;
+	stats->min = s->min;
+	stats->max = s->max;
+	total = s->total;
+	memcpy(stats->hist, s->hist, sizeof(stats->hist));
+	RESTORE_CPU_IPL(ipl);
+
+	stats->avg = stats->count ? total / stats->count : 0;
+
+	return true;
+}
+
+void Latency_Reset(uint8_t source) {
+	if (source >= LATENCY_SOURCES) {
+		return;
+	}
+
+	Latency_Source *s = &latency_sources[source];
+	uint16_t ipl;
+
+	// Keep start and depth, the source may be inside a section right now
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	s->count = 0;
+	s->min = 0;
+	s->max = 0;
+	s->total = 0;
+	memset(s->hist, 0, sizeof(s->hist));
+	RESTORE_CPU_IPL(ipl);
+}
+
+void Latency_ResetAll() {
+	for (uint8_t i=0; i<LATENCY_SOURCES; i++) {
+		Latency_Reset(i);
+	}
+}
+
+void Latency_Print(int fd) {
+	Latency_Stats stats;
+
+	dprintf(fd, "%-10s %8s %8s %8s %8s  Histogram (<2us, then x2 each)\n", "Source", "Count", "Min us", "Avg us", "Max us");
+
+	for (uint8_t i=0; i<LATENCY_SOURCES; i++) {
+		Latency_Get(i, &stats);
+
+		if (!stats.count) {
+			continue;
+		}
+
+		if (i < LATENCY_USER) {
+			dprintf(fd, "%-10s", latency_names[i]);
+		} else {
+			dprintf(fd, "User %-5u", i - LATENCY_USER);
+		}
+
+		dprintf(fd, " %8lu %8lu %8lu %8lu ", stats.count, stats.min / FCY_DIV_1000000, stats.avg / FCY_DIV_1000000,
+			stats.max / FCY_DIV_1000000);
+
+		for (uint8_t j=0; j<PICo24_Latency_HistBins; j++) {
+			dprintf(fd, " %lu", stats.hist[j]);
+		}
+
+		dprintf(fd, "\n");
+	}
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Opt-in timing of interrupt-masked sections and ISRs, enabled by the
+ * "Latency" feature (PICo24_Latency_Enabled). Every source keeps the
+ * min/avg/max and a log2 histogram of its durations in instruction cycles,
+ * measured with the Timebase, so the TIMER peripheral is needed and
+ * PICo24_Timebase_Initialize() should be called early.
+ *
+ * Enter/exit pairs of one source may nest, only the outermost pair counts.
+ * Latency_Abort() drops a section that is open, and the exit that would have
+ * closed it is then ignored. LATENCY_CRITICAL is aborted on every context
+ * switch (traceTASK_SWITCHED_OUT), since the critical nesting belongs to the
+ * task and a section spanning a switch would include the time it's blocked.
+ * When disabled, the macros compile to nothing.
+ */
+
+#ifndef PICo24_Latency_UserSources
+#define PICo24_Latency_UserSources	4
+#endif
+
+// Bin 0 is below 32 cycles, each next one twice as wide, the last one is open ended
+#define PICo24_Latency_HistBins		12
+
+enum {
+	LATENCY_CRITICAL = 0,	// taskENTER_CRITICAL(), the kernel's interrupt mask
+	LATENCY_HEAP,		// umm heap lock, also counted in LATENCY_CRITICAL
+	LATENCY_USB_MASK,	// USBMaskInterrupts()
+	LATENCY_ISR_TICK,
+	LATENCY_ISR_USB,
+	LATENCY_ISR_I2C,
+	LATENCY_USER,		// First one free for applications
+	LATENCY_SOURCES = LATENCY_USER + PICo24_Latency_UserSources
+};
+
+typedef struct {
+	uint32_t count;
+	uint32_t min;		// In cycles
+	uint32_t max;
+	uint32_t avg;
+	uint32_t hist[PICo24_Latency_HistBins];
+} Latency_Stats;
+
+#ifdef PICo24_Latency_Enabled
+
+extern void Latency_Enter(uint8_t source);
+extern void Latency_Exit(uint8_t source);
+extern void Latency_Abort(uint8_t source);
+
+extern bool Latency_Get(uint8_t source, Latency_Stats *stats);
+extern void Latency_Reset(uint8_t source);
+extern void Latency_ResetAll();
+extern void Latency_Print(int fd);
+
+#define PICo24_LATENCY_ENTER(source)	Latency_Enter(source)
+#define PICo24_LATENCY_EXIT(source)	Latency_Exit(source)
+#define PICo24_LATENCY_ABORT(source)	Latency_Abort(source)
+
+#else
+
+#define PICo24_LATENCY_ENTER(source)
+#define PICo24_LATENCY_EXIT(source)
+#define PICo24_LATENCY_ABORT(source)
+
+#endif
\ No newline at end of file
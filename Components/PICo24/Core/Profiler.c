@@ -0,0 +1,216 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Profiler.h"
+
+#ifdef PICo24_Profiler_Enabled
+
+#include <xc.h>
+#include <string.h>
+
+#include <ScratchLibc/ScratchLibc.h>
+#include <PICo24/UnixAPI/mini_stdio.h>
+
+#include "Delay.h"
+#include "FreeRTOS_Support.h"
+
+static auto_eds Profiler_Entry *profiler_table;
+static volatile uint32_t profiler_samples, profiler_dropped;
+static volatile uint16_t profiler_used;
+static uint16_t profiler_rate;
+
+// Called by the OC1 interrupt stub in Profiler_ISR.S, at IPL 7. Keep it free of constant data, PSV isn't set up
+void Profiler_Sample(uint32_t pc) {
+	uint16_t task = 0;
+
+	_OC1IF = 0;
+
+#ifdef PICo24_FreeRTOS_Enabled
+	task = (uint16_t)xTaskGetCurrentTaskHandle();
+#endif
+
+	profiler_samples++;
+
+	uint16_t i = ((uint16_t)(pc >> 1) ^ (task << 3)) & (PICo24_Profiler_Slots - 1);
+
+	for (uint8_t probe=0; probe<PICo24_Profiler_Probes; probe++) {
+		auto_eds Profiler_Entry *e = &profiler_table[i];
+
+		if (!e->count) {
+			e->pc = pc;
+			e->task = task;
+			e->count = 1;
+			profiler_used++;
+			return;
+		}
+
+		if (e->pc == pc && e->task == task) {
+			if (e->count != UINT16_MAX) {
+				e->count++;
+			}
+			return;
+		}
+
+		i = (i + 1) & (PICo24_Profiler_Slots - 1);
+	}
+
+	profiler_dropped++;
+}
+
+bool Profiler_Start(uint16_t rate_hz) {
+	if (!profiler_table) {
+#ifdef __HAS_EDS__
+		profiler_table = malloc_eds(sizeof(Profiler_Entry) * PICo24_Profiler_Slots);
+#else
+		profiler_table = malloc(sizeof(Profiler_Entry) * PICo24_Profiler_Slots);
+#endif
+
+		if (!profiler_table) {
+			return false;
+		}
+
+		Profiler_Reset();
+	}
+
+	// OC1TMR counts FCY and is 16 bits wide
+	uint32_t period = FCY / (rate_hz ? rate_hz : 1);
+
+	if (period > 0x10000) {
+		period = 0x10000;
+	} else if (period < 400) {
+		period = 400;
+	}
+
+	profiler_rate = FCY / period;
+
+	_OC1IE = 0;
+	OC1CON1 = 0;
+	OC1CON2 = 0;
+	OC1CON1bits.OCTSEL = 0b111;	// FCY
+	OC1CON2bits.SYNCSEL = 0x1f;	// Own time base, reset when it reaches OC1RS
+	OC1R = 0;			// 0% duty, the pin isn't mapped anyway
+	OC1RS = period - 1;
+	OC1TMR = 0;
+	_OC1IF = 0;
+	_OC1IP = 7;
+	_OC1IE = 1;
+	OC1CON1bits.OCM = 0b110;	// Edge aligned PWM, interrupts every period
+
+	return true;
+}
+
+void Profiler_Stop() {
+	_OC1IE = 0;
+	OC1CON1bits.OCM = 0;
+	_OC1IF = 0;
+}
+
+void Profiler_Reset() {
+	if (!profiler_table) {
+		return;
+	}
+
+	// The sampler is the only writer, pause it rather than masking everything for the whole memset
+	bool running = _OC1IE;
+
+	_OC1IE = 0;
+#ifdef __HAS_EDS__
+	memset_eds(profiler_table, 0, sizeof(Profiler_Entry) * PICo24_Profiler_Slots);
+#else
+	memset(profiler_table, 0, sizeof(Profiler_Entry) * PICo24_Profiler_Slots);
+#endif
+	profiler_samples = 0;
+	profiler_dropped = 0;
+	profiler_used = 0;
+	_OC1IE = running;
+}
+
+void Profiler_GetStats(Profiler_Stats *stats) {
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	stats->samples = profiler_samples;
+	stats->dropped = profiler_dropped;
+	stats->used = profiler_used;
+	RESTORE_CPU_IPL(ipl);
+
+	stats->rate_hz = profiler_rate;
+	stats->running = _OC1IE;
+}
+
+/*
+ * Text, so it can be captured from the console along with other output:
+ * PROFILE <fcy> <rate> <samples> <dropped>
+ * P <task> <pc> <count>	(hex)
+ * T <task> <name>
+ * END
+ */
+void Profiler_Export(int fd) {
+	Profiler_Stats stats;
+	Profiler_Entry e;
+	uint16_t ipl;
+
+	Profiler_GetStats(&stats);
+
+	dprintf(fd, "PROFILE %lu %u %lu %lu\n", FCY, stats.rate_hz, stats.samples, stats.dropped);
+
+	if (!profiler_table) {
+		dprintf(fd, "END\n");
+		return;
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	uint16_t tasks[PICo24_TaskStats_MaxTasks];
+	uint8_t task_count = 0;
+#endif
+
+	for (uint16_t i=0; i<PICo24_Profiler_Slots; i++) {
+		SET_AND_SAVE_CPU_IPL(ipl, 7);
+		e = profiler_table[i];
+		RESTORE_CPU_IPL(ipl);
+
+		if (!e.count) {
+			continue;
+		}
+
+		dprintf(fd, "P %x %lx %u\n", e.task, e.pc, e.count);
+
+#ifdef PICo24_FreeRTOS_Enabled
+		if (e.task) {
+			uint8_t j;
+
+			for (j=0; j<task_count && tasks[j] != e.task; j++);
+
+			if (j == task_count && task_count < PICo24_TaskStats_MaxTasks) {
+				tasks[task_count++] = e.task;
+			}
+		}
+#endif
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	for (uint8_t j=0; j<task_count; j++) {
+		dprintf(fd, "T %x %s\n", tasks[j], pcTaskGetName((TaskHandle_t)tasks[j]));
+	}
+#endif
+
+	dprintf(fd, "END\n");
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Statistical sampling profiler, enabled by the "Profiler" feature
+ * (PICo24_Profiler_Enabled). A periodic interrupt at IPL 7 takes the PC it
+ * interrupted from the stack, and counts it together with the current task
+ * handle in a hash table in EDS. Other ISRs and interrupt masked code are
+ * sampled too, only sections running at IPL 7 themselves are invisible.
+ *
+ * The timer is Output Compare 1 with its own time base clocked at FCY, as
+ * Timer 1-5 are taken by the tick, the Timebase and the Alarms. Don't use
+ * OC1 for anything else while the profiler is enabled.
+ *
+ * Profiler_Export() prints the table as text, Tools/profile2sym.py maps the
+ * addresses to functions using the ELF. Pick a rate that isn't a multiple
+ * of the tick rate, or periodic work gets over or under sampled.
+ */
+
+#ifndef PICo24_Profiler_Slots
+#define PICo24_Profiler_Slots		1024	// Power of 2, 8 bytes each
+#endif
+
+// Give up on a sample after this many occupied slots
+#ifndef PICo24_Profiler_Probes
+#define PICo24_Profiler_Probes		8
+#endif
+
+typedef struct {
+	uint32_t pc;
+	uint16_t task;		// Task handle, 0 before the scheduler runs
+	uint16_t count;		// Saturates
+} Profiler_Entry;
+
+typedef struct {
+	uint32_t samples;
+	uint32_t dropped;	// Table full around that PC
+	uint16_t used;
+	uint16_t rate_hz;
+	bool running;
+} Profiler_Stats;
+
+#ifdef PICo24_Profiler_Enabled
+
+extern bool Profiler_Start(uint16_t rate_hz);
+extern void Profiler_Stop();
+extern void Profiler_Reset();
+
+extern void Profiler_GetStats(Profiler_Stats *stats);
+extern void Profiler_Export(int fd);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "StackAudit.h"
+
+#ifdef PICo24_FreeRTOS_Enabled
+
+#include <PICo24/UnixAPI/mini_stdio.h>
+
+static int stackaudit_fd;
+static TickType_t stackaudit_period;
+
+uint16_t StackAudit_Recommend(uint16_t used_max) {
+	uint32_t r = used_max + (uint32_t)used_max * PICo24_StackAudit_MarginPercent / 100 + PICo24_StackAudit_MarginWords;
+
+	// Keep it tidy, and never below what the kernel needs to start a task
+	r = (r + 15) & ~15UL;
+
+	if (r < configMINIMAL_STACK_SIZE) {
+		r = configMINIMAL_STACK_SIZE;
+	}
+
+	return r > UINT16_MAX ? UINT16_MAX : r;
+}
+
+uint8_t StackAudit_Sample(StackAudit_Entry *entries, uint8_t max) {
+	uint8_t ret = 0;
+
+	for (uint8_t i=1; i<=PICo24_TaskStats_MaxTasks && ret<max; i++) {
+		PICo24_TaskStack *s = &PICo24_TaskStacks[i];
+		StackAudit_Entry *e = &entries[ret];
+		uint16_t free_min;
+
+		// Keeps the task from being deleted under us, see PICo24_TaskDeleted()
+		vTaskSuspendAll();
+
+		if (!s->handle) {
+			xTaskResumeAll();
+			continue;
+		}
+
+		free_min = uxTaskGetStackHighWaterMark(s->handle);
+		e->handle = s->handle;
+		e->name = pcTaskGetName(s->handle);
+		e->size = s->size;
+
+		xTaskResumeAll();
+
+		e->used_max = e->size > free_min ? e->size - free_min : 0;
+		e->recommended = StackAudit_Recommend(e->used_max);
+		ret++;
+	}
+
+	return ret;
+}
+
+void StackAudit_Print(int fd) {
+	StackAudit_Entry entries[PICo24_TaskStats_MaxTasks];
+	uint8_t n = StackAudit_Sample(entries, PICo24_TaskStats_MaxTasks);
+	int32_t reclaim = 0;
+
+	dprintf(fd, "%-16s %6s %6s %6s %6s\n", "Task", "Size", "Used", "Rec", "Spare");
+
+	for (uint8_t i=0; i<n; i++) {
+		StackAudit_Entry *e = &entries[i];
+		int16_t spare = e->size - e->recommended;
+
+		dprintf(fd, "%-16s %6u %6u %6u %6d%s\n", e->name, e->size, e->used_max, e->recommended, spare,
+			e->used_max + PICo24_StackAudit_MarginWords > e->size ? " LOW" : "");
+
+		reclaim += spare;
+	}
+
+	dprintf(fd, "Reclaimable: %ld bytes\n", reclaim * (int32_t)sizeof(StackType_t));
+}
+
+static void StackAudit_Task(void *userp) {
+	uint16_t last_used[PICo24_TaskStats_MaxTasks + 1] = {0};
+	TickType_t last = xTaskGetTickCount();
+
+	while (1) {
+		bool changed = false;
+
+		for (uint8_t i=1; i<=PICo24_TaskStats_MaxTasks; i++) {
+			PICo24_TaskStack *s = &PICo24_TaskStacks[i];
+			uint16_t free_min, used;
+
+			vTaskSuspendAll();
+
+			if (!s->handle) {
+				xTaskResumeAll();
+				continue;
+			}
+
+			free_min = uxTaskGetStackHighWaterMark(s->handle);
+			used = s->size > free_min ? s->size - free_min : 0;
+
+			xTaskResumeAll();
+
+			if (used > last_used[i]) {
+				last_used[i] = used;
+				changed = true;
+			}
+		}
+
+		if (changed) {
+			StackAudit_Print(stackaudit_fd);
+		}
+
+		vTaskDelayUntil(&last, stackaudit_period);
+	}
+}
+
+bool StackAudit_Start(int fd, uint32_t period_ms) {
+	stackaudit_fd = fd;
+	stackaudit_period = period_ms / portTICK_PERIOD_MS;
+
+	if (!stackaudit_period) {
+		stackaudit_period = 1;
+	}
+
+	return xTaskCreate(StackAudit_Task, "StackAudit", PICo24_StackAudit_StackSize, NULL, 1, NULL) == pdPASS;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS_Support.h"
+
+#ifdef PICo24_FreeRTOS_Enabled
+
+/*
+ * Task stack auditor. The kernel fills every new stack with a known pattern
+ * (configCHECK_FOR_STACK_OVERFLOW is 2), so the deepest point a task ever
+ * reached is where the pattern stops. This compares that with the size the
+ * task was created with, and recommends a size with some margin.
+ *
+ * On this port ISRs run on the stack of whatever task they interrupt, so the
+ * fixed margin has to cover the deepest nesting of ISRs too. Let everything
+ * run through its worst case (enumeration, heavy traffic, errors) before
+ * trusting the figures.
+ *
+ * Sizes are in words, like xTaskCreate() takes them.
+ */
+
+#ifndef PICo24_StackAudit_MarginPercent
+#define PICo24_StackAudit_MarginPercent		20
+#endif
+
+// ISR frames and whatever the test run missed
+#ifndef PICo24_StackAudit_MarginWords
+#define PICo24_StackAudit_MarginWords		64
+#endif
+
+#ifndef PICo24_StackAudit_StackSize
+#define PICo24_StackAudit_StackSize		384
+#endif
+
+typedef struct {
+	TaskHandle_t handle;
+	const char *name;	// Inside the TCB, only valid while the task exists
+	uint16_t size;
+	uint16_t used_max;
+	uint16_t recommended;
+} StackAudit_Entry;
+
+extern uint16_t StackAudit_Recommend(uint16_t used_max);
+extern uint8_t StackAudit_Sample(StackAudit_Entry *entries, uint8_t max);
+extern void StackAudit_Print(int fd);
+
+// Checks every period, prints the table whenever a task went deeper than before
+extern bool StackAudit_Start(int fd, uint32_t period_ms);
+
+#endif
\ No newline at end of file
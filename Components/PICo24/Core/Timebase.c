@@ -0,0 +1,93 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Timebase.h"
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+
+#include <xc.h>
+
+#include "Delay.h"
+
+static volatile uint32_t timebase_high;
+
+static void Timebase_Overflow(void *userp) {
+	timebase_high++;
+}
+
+void PICo24_Timebase_Initialize() {
+	Timer_HandleTypeDef *htimer = &PICo24_Timebase_Timer;
+
+	Timer_Initialize(htimer, TIMER_32BIT);
+	Timer_SetSpeedByPrescaler(htimer, TIMER_PS_1_1);
+	Timer_SetPeriod(htimer, 0xffffffff);
+
+	timebase_high = 0;
+
+	// In 32-bit mode the interrupt comes from the upper timer
+	Timer_SetInterruptHandler(htimer->UPPER, Timebase_Overflow, NULL);
+	Timer_SetInterrupt(htimer->UPPER, true);
+
+	// Also starts it
+	Timer_SetValue(htimer, 0);
+}
+
+uint64_t PICo24_NowTicks() {
+	Timer_HandleTypeDef *upper = PICo24_Timebase_Timer.UPPER;
+	uint16_t ipl;
+	uint32_t high, low;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	low = PICo24_CycleStamp();
+	high = timebase_high;
+
+	// Wrapped, but the interrupt hasn't been serviced yet
+	if (*upper->IFS & (1U << upper->IFS_OFFSET)) {
+		low = PICo24_CycleStamp();
+		high++;
+	}
+
+	RESTORE_CPU_IPL(ipl);
+
+	return ((uint64_t)high << 32) | low;
+}
+
+uint64_t PICo24_NowMicroseconds() {
+	return PICo24_TicksToMicroseconds(PICo24_NowTicks());
+}
+
+// Split in whole seconds and the rest, so nothing overflows
+uint64_t PICo24_TicksToMicroseconds(uint64_t ticks) {
+	return (ticks / FCY) * 1000000 + (ticks % FCY) * 1000000 / FCY;
+}
+
+uint64_t PICo24_TicksToNanoseconds(uint64_t ticks) {
+	return (ticks / FCY) * 1000000000 + (ticks % FCY) * 1000000000 / FCY;
+}
+
+uint64_t PICo24_MicrosecondsToTicks(uint64_t microseconds) {
+	return (microseconds / 1000000) * FCY + (microseconds % 1000000) * FCY / 1000000;
+}
+
+uint32_t PICo24_CyclesToMicroseconds(uint32_t cycles) {
+	return cycles / FCY_DIV_1000000;
+}
+
+#endif
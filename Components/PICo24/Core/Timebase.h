@@ -0,0 +1,61 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+
+#include <PICo24/Peripherals/Timer/Timer.h>
+
+/*
+ * Monotonic timebase: a free-running 32-bit timer pair counting instruction
+ * cycles (FCY), extended to 64 bits by its overflow interrupt, so it doesn't
+ * wrap for as long as anyone cares. Timer 4/5 by default, define
+ * PICo24_Timebase_Timer as htimer2 to use Timer 2/3 instead.
+ *
+ * PICo24_NowTicks() briefly disables interrupts, and the conversions use 64-bit
+ * divisions. For profiling hot paths, take PICo24_CycleStamp()s and convert
+ * the difference later.
+ */
+
+#ifndef PICo24_Timebase_Timer
+#define PICo24_Timebase_Timer	htimer4
+#endif
+
+extern void PICo24_Timebase_Initialize();
+
+extern uint64_t PICo24_NowTicks();
+extern uint64_t PICo24_NowMicroseconds();
+
+extern uint64_t PICo24_TicksToMicroseconds(uint64_t ticks);
+extern uint64_t PICo24_TicksToNanoseconds(uint64_t ticks);
+extern uint64_t PICo24_MicrosecondsToTicks(uint64_t microseconds);
+extern uint32_t PICo24_CyclesToMicroseconds(uint32_t cycles);
+
+// Low 32 bits of the timebase, wraps every 2^32 cycles (~268s at 16 MIPS), so only use differences
+static inline uint32_t PICo24_CycleStamp() {
+	// Reading the low half latches the high half into TMRxHLD
+	uint16_t lo = *PICo24_Timebase_Timer.VAL;
+
+	return ((uint32_t)*PICo24_Timebase_Timer.UPPER->VALHLD << 16) | lo;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,270 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Trace.h"
+
+#ifdef PICo24_Trace_Enabled
+
+#ifndef PICo24_Enable_Peripheral_TIMER
+#error The Trace feature needs the TIMER peripheral for the Timebase
+#endif
+
+#include <xc.h>
+#include <string.h>
+
+#include <ScratchLibc/ScratchLibc.h>
+#include <PICo24/UnixAPI/mini_unistd.h>
+
+#include "Timebase.h"
+#include "Delay.h"
+#include "FreeRTOS_Support.h"
+
+// Records copied out per interrupt mask, and per 'R' frame
+#define TRACE_FLUSH_BATCH	8
+
+static auto_eds Trace_Record *trace_ring;
+static volatile uint16_t trace_head, trace_tail;
+static volatile uint32_t trace_recorded, trace_dropped;
+static volatile bool trace_enabled;
+
+#ifdef PICo24_FreeRTOS_Enabled
+static const char *trace_task_names[PICo24_TaskStats_MaxTasks + 1];
+static volatile bool trace_names_changed;
+
+static int trace_stream_fd;
+static TickType_t trace_stream_period;
+#endif
+
+bool Trace_Initialize() {
+	if (trace_ring) {
+		return true;
+	}
+
+#ifdef __HAS_EDS__
+	trace_ring = malloc_eds(sizeof(Trace_Record) * PICo24_Trace_Records);
+#else
+	trace_ring = malloc(sizeof(Trace_Record) * PICo24_Trace_Records);
+#endif
+
+	if (!trace_ring) {
+		return false;
+	}
+
+	trace_head = trace_tail = 0;
+	trace_enabled = true;
+
+	return true;
+}
+
+void Trace_Enable(bool enabled) {
+	trace_enabled = enabled && trace_ring;
+}
+
+void Trace_Event(uint16_t id, uint16_t arg0, uint32_t arg1) {
+	uint16_t ipl;
+
+	if (!trace_enabled) {
+		return;
+	}
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	if ((uint16_t)(trace_head - trace_tail) >= PICo24_Trace_Records) {
+		trace_dropped++;
+#if PICo24_Trace_Overwrite
+		trace_tail++;
+#else
+		RESTORE_CPU_IPL(ipl);
+		return;
+#endif
+	}
+
+	auto_eds Trace_Record *r = &trace_ring[trace_head & (PICo24_Trace_Records - 1)];
+
+	r->stamp = PICo24_CycleStamp();
+	r->id = id;
+	r->arg0 = arg0;
+	r->arg1 = arg1;
+
+	trace_head++;
+	trace_recorded++;
+
+	RESTORE_CPU_IPL(ipl);
+}
+
+// Called by the kernel with the new TCB, the name lives as long as the task
+void Trace_TaskCreated(uint8_t number, const char *name) {
+#ifdef PICo24_FreeRTOS_Enabled
+	if (number <= PICo24_TaskStats_MaxTasks) {
+		trace_task_names[number] = name;
+		trace_names_changed = true;
+	}
+#endif
+}
+
+// Called by the kernel before the TCB holding the name is freed
+void Trace_TaskDeleted(uint8_t number) {
+#ifdef PICo24_FreeRTOS_Enabled
+	if (number <= PICo24_TaskStats_MaxTasks) {
+		trace_task_names[number] = NULL;
+		trace_names_changed = true;
+	}
+#endif
+}
+
+void Trace_GetStats(Trace_Stats *stats) {
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	stats->recorded = trace_recorded;
+	stats->dropped = trace_dropped;
+	stats->pending = trace_head - trace_tail;
+	RESTORE_CPU_IPL(ipl);
+}
+
+static void Trace_WriteHeader(int fd, char type, uint16_t len) {
+	uint8_t hdr[5] = {'P', 'T', type, len & 0xff, len >> 8};
+
+	write(fd, hdr, sizeof(hdr));
+}
+
+static void Trace_WriteFrame(int fd, char type, const void *payload, uint16_t len) {
+	Trace_WriteHeader(fd, type, len);
+	write(fd, payload, len);
+}
+
+// Not reentrant, there should be a single reader
+uint16_t Trace_Flush(int fd) {
+	Trace_Record batch[TRACE_FLUSH_BATCH];
+	Trace_Stats stats;
+	uint32_t info[3];
+	uint16_t ret = 0;
+	uint16_t ipl;
+
+	Trace_GetStats(&stats);
+
+	info[0] = FCY;
+	info[1] = stats.recorded;
+	info[2] = stats.dropped;
+	Trace_WriteFrame(fd, 'I', info, sizeof(info));
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (trace_names_changed) {
+		uint8_t entry[1 + PICo24_Trace_NameLength];
+		uint16_t count = 0;
+
+		trace_names_changed = false;
+
+		for (uint8_t i=0; i<=PICo24_TaskStats_MaxTasks; i++) {
+			if (trace_task_names[i]) {
+				count++;
+			}
+		}
+
+		Trace_WriteHeader(fd, 'N', count * sizeof(entry));
+
+		for (uint8_t i=0; i<=PICo24_TaskStats_MaxTasks && count; i++) {
+			bool valid;
+
+			// The task can't be deleted while the scheduler is suspended, but write() may block
+			vTaskSuspendAll();
+			valid = trace_task_names[i] != NULL;
+			if (valid) {
+				strncpy((char *)entry + 1, trace_task_names[i], PICo24_Trace_NameLength);
+			}
+			xTaskResumeAll();
+
+			if (valid) {
+				entry[0] = i;
+				write(fd, entry, sizeof(entry));
+				count--;
+			}
+		}
+
+		// Deleted since counting, pad the frame to the announced length with nameless entries
+		memset(entry, 0, sizeof(entry));
+
+		while (count--) {
+			write(fd, entry, sizeof(entry));
+		}
+	}
+#endif
+
+	// Writing out may well generate more events, so stop after one ring's worth
+	while (ret < PICo24_Trace_Records) {
+		uint8_t n = 0;
+
+		// One record per mask, the writers may be overwriting the oldest ones meanwhile
+		while (n < TRACE_FLUSH_BATCH) {
+			SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+			if (trace_tail == trace_head) {
+				RESTORE_CPU_IPL(ipl);
+				break;
+			}
+
+			batch[n++] = trace_ring[trace_tail & (PICo24_Trace_Records - 1)];
+			trace_tail++;
+
+			RESTORE_CPU_IPL(ipl);
+		}
+
+		if (!n) {
+			break;
+		}
+
+		Trace_WriteFrame(fd, 'R', batch, n * sizeof(Trace_Record));
+		ret += n;
+
+		if (n < TRACE_FLUSH_BATCH) {
+			break;
+		}
+	}
+
+	return ret;
+}
+
+#ifdef PICo24_FreeRTOS_Enabled
+static void Trace_StreamTask(void *userp) {
+	TickType_t last = xTaskGetTickCount();
+
+	while (1) {
+		vTaskDelayUntil(&last, trace_stream_period);
+		Trace_Flush(trace_stream_fd);
+	}
+}
+
+bool Trace_StartStream(int fd, uint32_t period_ms) {
+	trace_stream_fd = fd;
+	trace_stream_period = period_ms / portTICK_PERIOD_MS;
+
+	if (!trace_stream_period) {
+		trace_stream_period = 1;
+	}
+
+	return xTaskCreate(Trace_StreamTask, "Trace", PICo24_Trace_StreamStackSize, NULL, 1, NULL) == pdPASS;
+}
+#else
+// Without a scheduler, call Trace_Flush() from the main loop instead
+bool Trace_StartStream(int fd, uint32_t period_ms) {
+	return false;
+}
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Binary event trace, enabled by the "Trace" feature (PICo24_Trace_Enabled).
+ * Every event is a fixed 12 byte record, a Timebase cycle stamp, an event id
+ * and two arguments, appended to a ring in EDS (or near RAM on parts without
+ * it). Recording is safe from tasks and ISRs of any priority, and only masks
+ * interrupts for the few instructions it takes to fill the record, so unlike
+ * printf it barely moves the timing of what's being looked at.
+ *
+ * Trace_Flush() streams the pending records to a fd (UART, CDC ACM) as
+ * frames, Tools/trace2chrome.py turns a capture of that into Chrome trace
+ * JSON (chrome://tracing, Perfetto).
+ *
+ * Built in events are task switches (FreeRTOS trace hooks), USB device
+ * transactions and heap allocations. Applications can add their own from
+ * TRACE_EV_USER on, and mark slices with TRACE_EV_BEGIN/TRACE_EV_END.
+ *
+ * Stamps are 32 bits and wrap every 2^32 cycles (~268s at 16 MIPS), the
+ * decoder unwraps them as long as no gap between events is that long.
+ */
+
+#ifndef PICo24_Trace_Records
+#define PICo24_Trace_Records		256	// Power of 2
+#endif
+
+// When the ring is full, drop the oldest record (snapshot of the latest
+// events) instead of the newest one (nothing lost before the stall)
+#ifndef PICo24_Trace_Overwrite
+#define PICo24_Trace_Overwrite		0
+#endif
+
+#ifndef PICo24_Trace_StreamStackSize
+#define PICo24_Trace_StreamStackSize	256
+#endif
+
+enum {
+	TRACE_EV_TASK_SWITCH = 1,	// arg0: task number
+	TRACE_EV_USB_TRANSFER,		// arg0: U1STAT (endpoint, direction, ping-pong)
+	TRACE_EV_MALLOC,		// arg0: heap, arg1: bytes
+	TRACE_EV_FREE,			// arg0: heap, arg1: bytes
+	TRACE_EV_BEGIN,			// arg0: slice id, arg1: anything
+	TRACE_EV_END,			// arg0: slice id, arg1: anything
+	TRACE_EV_USER = 0x100		// First one free for applications
+};
+
+typedef struct {
+	uint32_t stamp;
+	uint16_t id;
+	uint16_t arg0;
+	uint32_t arg1;
+} Trace_Record;
+
+/*
+ * Stream format, little endian. Every frame is "PT", a type byte, a 16-bit
+ * payload length and the payload:
+ * 'I': uint32_t FCY, uint32_t recorded, uint32_t dropped
+ * 'N': { uint8_t task number, char name[PICo24_Trace_NameLength] } per task
+ * 'R': Trace_Record, as many as fit
+ */
+
+#define PICo24_Trace_NameLength		16
+
+typedef struct {
+	uint32_t recorded;
+	uint32_t dropped;
+	uint16_t pending;
+} Trace_Stats;
+
+#ifdef PICo24_Trace_Enabled
+
+extern bool Trace_Initialize();
+extern void Trace_Enable(bool enabled);
+
+extern void Trace_Event(uint16_t id, uint16_t arg0, uint32_t arg1);
+extern void Trace_TaskCreated(uint8_t number, const char *name);
+extern void Trace_TaskDeleted(uint8_t number);
+
+extern void Trace_GetStats(Trace_Stats *stats);
+
+// Returns the number of records written
+extern uint16_t Trace_Flush(int fd);
+extern bool Trace_StartStream(int fd, uint32_t period_ms);
+
+#define PICo24_TRACE(id, arg0, arg1)	Trace_Event(id, arg0, arg1)
+
+#else
+
+#define PICo24_TRACE(id, arg0, arg1)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,236 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "HashSet.h"
+#include <PICo24/Library/SafeMalloc.h>
+
+enum {
+	HashSet_SlotEmpty = 0,
+	HashSet_SlotUsed = 1,
+	HashSet_SlotDeleted = 2
+};
+
+static uint16_t HashSet_Hash(const void *key, size_t len) {
+	const uint8_t *p = key;
+	uint16_t h = 0x811c;
+
+	for (size_t i=0; i<len; i++) {
+		h = (h ^ p[i]) * 0x0101;
+		h ^= h >> 7;
+	}
+
+	return h;
+}
+
+static inline void *HashSet_Slot(HashSet *set, size_t idx) {
+	return ((uint8_t *)set->data) + set->element_size * idx;
+}
+
+// Returns the slot holding the key, or the slot it should be inserted into, or capacity if the table is full
+static size_t HashSet_Probe(HashSet *set, const void *key, bool *found) {
+	size_t mask = set->capacity - 1;
+	size_t idx = HashSet_Hash(key, set->key_size) & mask;
+	size_t first_deleted = set->capacity;
+
+	*found = false;
+
+	for (size_t i=0; i<set->capacity; i++) {
+		uint8_t state = set->states[idx];
+
+		if (state == HashSet_SlotEmpty) {
+			return first_deleted != set->capacity ? first_deleted : idx;
+		} else if (state == HashSet_SlotDeleted) {
+			if (first_deleted == set->capacity) {
+				first_deleted = idx;
+			}
+		} else if (memcmp(HashSet_Slot(set, idx), key, set->key_size) == 0) {
+			*found = true;
+			return idx;
+		}
+
+		idx = (idx + 1) & mask;
+	}
+
+	return first_deleted;
+}
+
+// The set is left as it was if the new table can't be allocated
+static bool HashSet_Rehash(HashSet *set, size_t new_capacity) {
+	uint8_t *old_states = set->states;
+	void *old_data = set->data;
+	size_t old_capacity = set->capacity;
+	uint8_t *new_states = calloc(new_capacity, 1);
+	void *new_data = malloc(set->element_size * new_capacity);
+
+	if (!new_states || !new_data) {
+		if (new_states) {
+			free(new_states);
+		}
+
+		if (new_data) {
+			free(new_data);
+		}
+
+		return false;
+	}
+
+	set->states = new_states;
+	set->data = new_data;
+	set->capacity = new_capacity;
+	set->size = 0;
+	set->tombstones = 0;
+
+	for (size_t i=0; i<old_capacity; i++) {
+		if (old_states[i] == HashSet_SlotUsed) {
+			bool found;
+			const void *obj = ((uint8_t *)old_data) + set->element_size * i;
+			size_t idx = HashSet_Probe(set, obj, &found);
+
+			memcpy(HashSet_Slot(set, idx), obj, set->element_size);
+			set->states[idx] = HashSet_SlotUsed;
+			set->size++;
+		}
+	}
+
+	if (old_capacity) {
+		free(old_states);
+		free(old_data);
+	}
+
+	return true;
+}
+
+void HashSet_Init(HashSet *set, size_t element_size) {
+	HashSet_InitMap(set, element_size, element_size);
+}
+
+void HashSet_InitMap(HashSet *set, size_t element_size, size_t key_size) {
+	memset(set, 0, sizeof(HashSet));
+	set->element_size = element_size;
+	set->key_size = key_size;
+}
+
+void HashSet_Clear(HashSet *set) {
+	if (set->capacity) {
+		free(set->states);
+		free(set->data);
+	}
+
+	set->states = NULL;
+	set->data = NULL;
+	set->size = 0;
+	set->capacity = 0;
+	set->tombstones = 0;
+}
+
+bool HashSet_Reserve(HashSet *set, size_t n) {
+	size_t new_capacity = set->capacity ? set->capacity : HashSet_MinCapacity;
+
+	// Keep the load factor (including tombstones) at or below 3/4
+	while (new_capacity - new_capacity / 4 < n) {
+		new_capacity *= 2;
+	}
+
+	if (new_capacity != set->capacity) {
+		return HashSet_Rehash(set, new_capacity);
+	}
+
+	return true;
+}
+
+bool HashSet_Insert(HashSet *set, const void *object) {
+	if (set->size + set->tombstones + 1 > set->capacity - set->capacity / 4) {
+		size_t capacity = set->capacity;
+
+		HashSet_Reserve(set, set->size + 1);
+
+		// Big enough for the elements alone, so it's the tombstones filling the table up
+		if (set->capacity == capacity && capacity) {
+			HashSet_Rehash(set, capacity);
+		}
+	}
+
+	bool found;
+	size_t idx = HashSet_Probe(set, object, &found);
+
+	// Out of memory with no free slot left
+	if (found || idx == set->capacity) {
+		return false;
+	}
+
+	if (set->states[idx] == HashSet_SlotDeleted) {
+		set->tombstones--;
+	}
+
+	memcpy(HashSet_Slot(set, idx), object, set->element_size);
+	set->states[idx] = HashSet_SlotUsed;
+	set->size++;
+
+	return true;
+}
+
+void *HashSet_Find(HashSet *set, const void *key) {
+	if (!set->size) {
+		return NULL;
+	}
+
+	bool found;
+	size_t idx = HashSet_Probe(set, key, &found);
+
+	return found ? HashSet_Slot(set, idx) : NULL;
+}
+
+bool HashSet_Contains(HashSet *set, const void *key) {
+	return HashSet_Find(set, key) != NULL;
+}
+
+bool HashSet_Erase(HashSet *set, const void *key) {
+	if (!set->size) {
+		return false;
+	}
+
+	bool found;
+	size_t idx = HashSet_Probe(set, key, &found);
+
+	if (!found) {
+		return false;
+	}
+
+	set->states[idx] = HashSet_SlotDeleted;
+	set->size--;
+	set->tombstones++;
+
+	return true;
+}
+
+bool HashSet_Empty(HashSet *set) {
+	return set->size == 0;
+}
+
+void *HashSet_Next(HashSet *set, const void *it) {
+	size_t idx = it ? (size_t)((const uint8_t *)it - (const uint8_t *)set->data) / set->element_size + 1 : 0;
+
+	for (; idx<set->capacity; idx++) {
+		if (set->states[idx] == HashSet_SlotUsed) {
+			return HashSet_Slot(set, idx);
+		}
+	}
+
+	return NULL;
+}
@@ -0,0 +1,55 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Open addressing hash set with linear probing. Elements are fixed size, and only the
+// first key_size bytes of an element are hashed and compared, so it also works as a map.
+
+typedef struct {
+	size_t size;
+	size_t capacity;
+	size_t tombstones;
+	size_t element_size;
+	size_t key_size;
+	uint8_t *states;
+	void *data;
+} HashSet;
+
+#define HashSet_MinCapacity	8
+
+#define HashSet_ForEach(item, set) \
+    for (void *item=HashSet_Next(&set, NULL); item; item=HashSet_Next(&set, item))
+
+extern void HashSet_Init(HashSet *set, size_t element_size);
+extern void HashSet_InitMap(HashSet *set, size_t element_size, size_t key_size);
+extern void HashSet_Clear(HashSet *set);
+// Both return false if the table couldn't be grown. Insert also returns false if the key is already present.
+extern bool HashSet_Reserve(HashSet *set, size_t n);
+extern bool HashSet_Insert(HashSet *set, const void *object);
+extern void *HashSet_Find(HashSet *set, const void *key);
+extern bool HashSet_Contains(HashSet *set, const void *key);
+extern bool HashSet_Erase(HashSet *set, const void *key);
+extern bool HashSet_Empty(HashSet *set);
+extern void *HashSet_Next(HashSet *set, const void *it);
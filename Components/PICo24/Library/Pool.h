@@ -0,0 +1,68 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "../Core/IDESupport.h"
+
+// Fixed size block pool. Blocks are carved from a caller supplied region, and free blocks are chained
+// through their first bytes, so alloc/free are O(1) and never touch the heap.
+// Pools created with isr_safe=true raise the CPU IPL to 7 around list updates and can be used from any
+// interrupt; otherwise a FreeRTOS critical section is used (when the scheduler is running).
+
+#ifndef PICo24_Pool_Stats
+#define PICo24_Pool_Stats	1
+#endif
+
+typedef struct {
+	uint16_t in_use;
+	uint16_t high_water;
+	uint16_t failures;
+} PoolStats;
+
+typedef struct {
+	uint8_t *region;
+	void *free_list;
+	uint16_t block_size;
+	uint16_t block_count;
+	uint16_t free_count;
+	bool isr_safe;
+#if PICo24_Pool_Stats
+	PoolStats stats;
+#endif
+} Pool;
+
+// Block sizes are rounded up to hold a free list link and keep word alignment
+#define Pool_BlockSize(size)			((((size) < sizeof(void *) ? sizeof(void *) : (size)) + 1) & ~1)
+#define Pool_RegionSize(size, count)		(Pool_BlockSize(size) * (count))
+#define Pool_DefineRegion(name, size, count)	uint8_t __attribute__((aligned(2))) name[Pool_RegionSize(size, count)]
+
+extern bool Pool_Init(Pool *pool, void *region, uint16_t block_size, uint16_t block_count, bool isr_safe);
+extern void *Pool_Alloc(Pool *pool);
+extern void *Pool_Calloc(Pool *pool);
+extern void Pool_Free(Pool *pool, void *block);
+extern bool Pool_Owns(Pool *pool, const void *p);
+extern uint16_t Pool_Available(Pool *pool);
+extern void Pool_GetStats(Pool *pool, PoolStats *stats);
+extern void Pool_ResetStats(Pool *pool);
\ No newline at end of file
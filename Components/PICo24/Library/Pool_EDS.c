@@ -0,0 +1,166 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Pool_EDS.h"
+
+#include <xc.h>
+#include <PICo24/Core/FreeRTOS_Support.h>
+#include <ScratchLibc/ScratchLibc.h>
+
+#ifdef __HAS_EDS__
+
+static inline uint16_t Pool_EDS_Lock(Pool_EDS *pool) {
+	uint16_t ipl = 0;
+
+	if (pool->isr_safe) {
+		SET_AND_SAVE_CPU_IPL(ipl, 7);
+	}
+#ifdef PICo24_FreeRTOS_Enabled
+	else if (freertos_started) {
+		taskENTER_CRITICAL();
+	}
+#endif
+
+	return ipl;
+}
+
+static inline void Pool_EDS_Unlock(Pool_EDS *pool, uint16_t ipl) {
+	if (pool->isr_safe) {
+		RESTORE_CPU_IPL(ipl);
+	}
+#ifdef PICo24_FreeRTOS_Enabled
+	else if (freertos_started) {
+		taskEXIT_CRITICAL();
+	}
+#endif
+}
+
+bool Pool_EDS_Init(Pool_EDS *pool, auto_eds void *region, uint16_t block_size, uint16_t block_count, bool isr_safe) {
+	memset(pool, 0, sizeof(Pool_EDS));
+
+	if (!region || !block_count) {
+		return false;
+	}
+
+	pool->region = region;
+	pool->block_size = Pool_EDS_BlockSize(block_size);
+	pool->block_count = block_count;
+	pool->free_count = block_count;
+	pool->isr_safe = isr_safe;
+
+	// Chain all blocks in address order
+	auto_eds uint8_t *p = pool->region;
+
+	for (uint16_t i=0; i<block_count-1; i++) {
+		*(auto_eds void **)p = p + pool->block_size;
+		p += pool->block_size;
+	}
+
+	*(auto_eds void **)p = NULL;
+	pool->free_list = pool->region;
+
+	return true;
+}
+
+auto_eds void *Pool_EDS_Alloc(Pool_EDS *pool) {
+	uint16_t ipl = Pool_EDS_Lock(pool);
+
+	auto_eds void *ret = pool->free_list;
+
+	if (ret) {
+		pool->free_list = *(auto_eds void **)ret;
+		pool->free_count--;
+#if PICo24_Pool_Stats
+		pool->stats.in_use++;
+
+		if (pool->stats.in_use > pool->stats.high_water) {
+			pool->stats.high_water = pool->stats.in_use;
+		}
+	} else {
+		pool->stats.failures++;
+#endif
+	}
+
+	Pool_EDS_Unlock(pool, ipl);
+
+	return ret;
+}
+
+auto_eds void *Pool_EDS_Calloc(Pool_EDS *pool) {
+	auto_eds void *ret = Pool_EDS_Alloc(pool);
+
+	if (ret) {
+		memset_eds(ret, 0, pool->block_size);
+	}
+
+	return ret;
+}
+
+void Pool_EDS_Free(Pool_EDS *pool, auto_eds void *block) {
+	if (!block) {
+		return;
+	}
+
+	uint16_t ipl = Pool_EDS_Lock(pool);
+
+	*(auto_eds void **)block = pool->free_list;
+	pool->free_list = block;
+	pool->free_count++;
+#if PICo24_Pool_Stats
+	pool->stats.in_use--;
+#endif
+
+	Pool_EDS_Unlock(pool, ipl);
+}
+
+bool Pool_EDS_Owns(Pool_EDS *pool, auto_eds const void *p) {
+	auto_eds const uint8_t *b = p;
+
+	if (b < pool->region || b >= pool->region + (uint32_t)pool->block_size * pool->block_count) {
+		return false;
+	}
+
+	return ((b - pool->region) % pool->block_size) == 0;
+}
+
+// A single word read, no need to lock
+uint16_t Pool_EDS_Available(Pool_EDS *pool) {
+	return *(volatile uint16_t *)&pool->free_count;
+}
+
+void Pool_EDS_GetStats(Pool_EDS *pool, PoolStats *stats) {
+#if PICo24_Pool_Stats
+	uint16_t ipl = Pool_EDS_Lock(pool);
+	memcpy(stats, &pool->stats, sizeof(PoolStats));
+	Pool_EDS_Unlock(pool, ipl);
+#else
+	memset(stats, 0, sizeof(PoolStats));
+#endif
+}
+
+void Pool_EDS_ResetStats(Pool_EDS *pool) {
+#if PICo24_Pool_Stats
+	uint16_t ipl = Pool_EDS_Lock(pool);
+	pool->stats.high_water = pool->stats.in_use;
+	pool->stats.failures = 0;
+	Pool_EDS_Unlock(pool, ipl);
+#endif
+}
+
+#endif
@@ -0,0 +1,66 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Pool.h"
+
+#ifdef __HAS_EDS__
+
+typedef struct {
+	auto_eds uint8_t *region;
+	auto_eds void *free_list;
+	uint16_t block_size;
+	uint16_t block_count;
+	uint16_t free_count;
+	bool isr_safe;
+#if PICo24_Pool_Stats
+	PoolStats stats;
+#endif
+} Pool_EDS;
+
+#define Pool_EDS_BlockSize(size)		((((size) < sizeof(auto_eds void *) ? sizeof(auto_eds void *) : (size)) + 1) & ~1)
+#define Pool_EDS_RegionSize(size, count)	((uint32_t)Pool_EDS_BlockSize(size) * (count))
+
+extern bool Pool_EDS_Init(Pool_EDS *pool, auto_eds void *region, uint16_t block_size, uint16_t block_count, bool isr_safe);
+extern auto_eds void *Pool_EDS_Alloc(Pool_EDS *pool);
+extern auto_eds void *Pool_EDS_Calloc(Pool_EDS *pool);
+extern void Pool_EDS_Free(Pool_EDS *pool, auto_eds void *block);
+extern bool Pool_EDS_Owns(Pool_EDS *pool, auto_eds const void *p);
+extern uint16_t Pool_EDS_Available(Pool_EDS *pool);
+extern void Pool_EDS_GetStats(Pool_EDS *pool, PoolStats *stats);
+extern void Pool_EDS_ResetStats(Pool_EDS *pool);
+
+#else
+
+typedef Pool Pool_EDS;
+
+#define Pool_EDS_BlockSize		Pool_BlockSize
+#define Pool_EDS_RegionSize		Pool_RegionSize
+
+#define Pool_EDS_Init			Pool_Init
+#define Pool_EDS_Alloc			Pool_Alloc
+#define Pool_EDS_Calloc			Pool_Calloc
+#define Pool_EDS_Free			Pool_Free
+#define Pool_EDS_Owns			Pool_Owns
+#define Pool_EDS_Available		Pool_Available
+#define Pool_EDS_GetStats		Pool_GetStats
+#define Pool_EDS_ResetStats		Pool_ResetStats
+
+#endif
\ No newline at end of file
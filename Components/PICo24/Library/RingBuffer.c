@@ -0,0 +1,289 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RingBuffer.h"
+
+bool RingBuffer_Init(RingBuffer *rb, uint8_t *buf, uint16_t size) {
+	memset(rb, 0, sizeof(RingBuffer));
+
+	if (size < 2 || size > 32768 || (size & (size - 1))) {
+		return false;
+	}
+
+	rb->buf = buf;
+	rb->mask = size - 1;
+
+	return true;
+}
+
+void RingBuffer_Reset(RingBuffer *rb) {
+	rb->tail = rb->head;
+}
+
+uint16_t RingBuffer_PeekWrite(RingBuffer *rb, uint8_t **span) {
+	uint16_t head = rb->head;
+	uint16_t free = RingBuffer_Size(rb) - (uint16_t)(head - rb->tail);
+	uint16_t idx = head & rb->mask;
+	uint16_t till_end = RingBuffer_Size(rb) - idx;
+
+	*span = rb->buf + idx;
+
+	return free < till_end ? free : till_end;
+}
+
+void RingBuffer_CommitWrite(RingBuffer *rb, uint16_t len) {
+	RingBuffer_Barrier();
+	rb->head += len;
+
+#ifdef PICo24_FreeRTOS_Enabled
+	RingBuffer_NotifyRx(rb);
+#endif
+}
+
+static uint16_t RingBuffer_DoWrite(RingBuffer *rb, const uint8_t *data, uint16_t len) {
+	uint16_t done = 0;
+
+	// At most two spans: up to the end of the buffer, then from the beginning
+	for (uint8_t i=0; i<2 && done<len; i++) {
+		uint8_t *span;
+		uint16_t n = RingBuffer_PeekWrite(rb, &span);
+
+		if (!n) {
+			break;
+		}
+
+		if (n > len - done) {
+			n = len - done;
+		}
+
+		memcpy(span, data + done, n);
+		RingBuffer_Barrier();
+		rb->head += n;
+		done += n;
+	}
+
+	return done;
+}
+
+uint16_t RingBuffer_Write(RingBuffer *rb, const uint8_t *data, uint16_t len) {
+	uint16_t done = RingBuffer_DoWrite(rb, data, len);
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (done) {
+		RingBuffer_NotifyRx(rb);
+	}
+#endif
+
+	return done;
+}
+
+uint16_t RingBuffer_PeekRead(RingBuffer *rb, uint8_t **span) {
+	uint16_t tail = rb->tail;
+	uint16_t used = (uint16_t)(rb->head - tail);
+	uint16_t idx = tail & rb->mask;
+	uint16_t till_end = RingBuffer_Size(rb) - idx;
+
+	RingBuffer_Barrier();
+
+	*span = rb->buf + idx;
+
+	return used < till_end ? used : till_end;
+}
+
+void RingBuffer_CommitRead(RingBuffer *rb, uint16_t len) {
+	RingBuffer_Barrier();
+	rb->tail += len;
+
+#ifdef PICo24_FreeRTOS_Enabled
+	RingBuffer_NotifyTx(rb);
+#endif
+}
+
+static uint16_t RingBuffer_DoRead(RingBuffer *rb, uint8_t *data, uint16_t len) {
+	uint16_t done = 0;
+
+	for (uint8_t i=0; i<2 && done<len; i++) {
+		uint8_t *span;
+		uint16_t n = RingBuffer_PeekRead(rb, &span);
+
+		if (!n) {
+			break;
+		}
+
+		if (n > len - done) {
+			n = len - done;
+		}
+
+		memcpy(data + done, span, n);
+		RingBuffer_Barrier();
+		rb->tail += n;
+		done += n;
+	}
+
+	return done;
+}
+
+uint16_t RingBuffer_Read(RingBuffer *rb, uint8_t *data, uint16_t len) {
+	uint16_t done = RingBuffer_DoRead(rb, data, len);
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (done) {
+		RingBuffer_NotifyTx(rb);
+	}
+#endif
+
+	return done;
+}
+
+#ifdef PICo24_FreeRTOS_Enabled
+void RingBuffer_SetRxNotify(RingBuffer *rb, TaskHandle_t task, uint16_t watermark) {
+	rb->rx_watermark = watermark ? watermark : 1;
+	RingBuffer_Barrier();
+	rb->rx_task = task;
+}
+
+void RingBuffer_SetTxNotify(RingBuffer *rb, TaskHandle_t task, uint16_t watermark) {
+	rb->tx_watermark = watermark ? watermark : 1;
+	RingBuffer_Barrier();
+	rb->tx_task = task;
+}
+
+void RingBuffer_NotifyRx(RingBuffer *rb) {
+	TaskHandle_t task = rb->rx_task;
+
+	if (task && RingBuffer_Used(rb) >= rb->rx_watermark) {
+		xTaskNotifyGive(task);
+	}
+}
+
+void RingBuffer_NotifyTx(RingBuffer *rb) {
+	TaskHandle_t task = rb->tx_task;
+
+	if (task && RingBuffer_Free(rb) >= rb->tx_watermark) {
+		xTaskNotifyGive(task);
+	}
+}
+
+void RingBuffer_NotifyRxFromISR(RingBuffer *rb, BaseType_t *woken) {
+	TaskHandle_t task = rb->rx_task;
+
+	if (task && RingBuffer_Used(rb) >= rb->rx_watermark) {
+		vTaskNotifyGiveFromISR(task, woken);
+	}
+}
+
+void RingBuffer_NotifyTxFromISR(RingBuffer *rb, BaseType_t *woken) {
+	TaskHandle_t task = rb->tx_task;
+
+	if (task && RingBuffer_Free(rb) >= rb->tx_watermark) {
+		vTaskNotifyGiveFromISR(task, woken);
+	}
+}
+
+void RingBuffer_CommitWriteFromISR(RingBuffer *rb, uint16_t len, BaseType_t *woken) {
+	RingBuffer_Barrier();
+	rb->head += len;
+	RingBuffer_NotifyRxFromISR(rb, woken);
+}
+
+void RingBuffer_CommitReadFromISR(RingBuffer *rb, uint16_t len, BaseType_t *woken) {
+	RingBuffer_Barrier();
+	rb->tail += len;
+	RingBuffer_NotifyTxFromISR(rb, woken);
+}
+
+uint16_t RingBuffer_WriteFromISR(RingBuffer *rb, const uint8_t *data, uint16_t len, BaseType_t *woken) {
+	uint16_t done = RingBuffer_DoWrite(rb, data, len);
+
+	if (done) {
+		RingBuffer_NotifyRxFromISR(rb, woken);
+	}
+
+	return done;
+}
+
+uint16_t RingBuffer_ReadFromISR(RingBuffer *rb, uint8_t *data, uint16_t len, BaseType_t *woken) {
+	uint16_t done = RingBuffer_DoRead(rb, data, len);
+
+	if (done) {
+		RingBuffer_NotifyTxFromISR(rb, woken);
+	}
+
+	return done;
+}
+
+bool RingBuffer_WaitReadable(RingBuffer *rb, uint16_t min_bytes, TickType_t timeout) {
+	if (min_bytes > RingBuffer_Size(rb)) {
+		min_bytes = RingBuffer_Size(rb);
+	}
+
+	if (RingBuffer_Used(rb) >= min_bytes) {
+		return true;
+	}
+
+	TickType_t start = xTaskGetTickCount();
+	bool ret;
+
+	RingBuffer_SetRxNotify(rb, xTaskGetCurrentTaskHandle(), min_bytes);
+
+	// Check again after registering, so a write that raced with us can't be missed
+	while (!(ret = RingBuffer_Used(rb) >= min_bytes)) {
+		TickType_t elapsed = xTaskGetTickCount() - start;
+
+		if (elapsed >= timeout) {
+			break;
+		}
+
+		ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+	}
+
+	rb->rx_task = NULL;
+
+	return ret;
+}
+
+bool RingBuffer_WaitWritable(RingBuffer *rb, uint16_t min_bytes, TickType_t timeout) {
+	if (min_bytes > RingBuffer_Size(rb)) {
+		min_bytes = RingBuffer_Size(rb);
+	}
+
+	if (RingBuffer_Free(rb) >= min_bytes) {
+		return true;
+	}
+
+	TickType_t start = xTaskGetTickCount();
+	bool ret;
+
+	RingBuffer_SetTxNotify(rb, xTaskGetCurrentTaskHandle(), min_bytes);
+
+	while (!(ret = RingBuffer_Free(rb) >= min_bytes)) {
+		TickType_t elapsed = xTaskGetTickCount() - start;
+
+		if (elapsed >= timeout) {
+			break;
+		}
+
+		ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+	}
+
+	rb->tx_task = NULL;
+
+	return ret;
+}
+#endif
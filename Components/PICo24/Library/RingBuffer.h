@@ -0,0 +1,134 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <PICo24/Core/FreeRTOS_Support.h>
+
+// Single producer, single consumer byte ring buffer.
+// Size must be a power of 2 (up to 32768). The indices are free running 16-bit words, which are read and
+// written atomically on PIC24, so one side may live in an ISR without any critical section.
+// Only the producer touches `head', and only the consumer touches `tail'.
+
+typedef struct {
+	uint8_t *buf;
+	uint16_t mask;
+	volatile uint16_t head;
+	volatile uint16_t tail;
+
+#ifdef PICo24_FreeRTOS_Enabled
+	// Notified when the used bytes reach rx_watermark after a write
+	volatile TaskHandle_t rx_task;
+	uint16_t rx_watermark;
+
+	// Notified when the free bytes reach tx_watermark after a read
+	volatile TaskHandle_t tx_task;
+	uint16_t tx_watermark;
+#endif
+} RingBuffer;
+
+#define RingBuffer_Barrier()	__asm__ __volatile__("" ::: "memory")
+
+extern bool RingBuffer_Init(RingBuffer *rb, uint8_t *buf, uint16_t size);
+extern void RingBuffer_Reset(RingBuffer *rb);
+
+static inline uint16_t RingBuffer_Size(const RingBuffer *rb) {
+	return rb->mask + 1;
+}
+
+static inline uint16_t RingBuffer_Used(const RingBuffer *rb) {
+	return (uint16_t)(rb->head - rb->tail);
+}
+
+static inline uint16_t RingBuffer_Free(const RingBuffer *rb) {
+	return RingBuffer_Size(rb) - RingBuffer_Used(rb);
+}
+
+static inline bool RingBuffer_Empty(const RingBuffer *rb) {
+	return rb->head == rb->tail;
+}
+
+static inline bool RingBuffer_Full(const RingBuffer *rb) {
+	return RingBuffer_Used(rb) == RingBuffer_Size(rb);
+}
+
+// Producer side
+extern uint16_t RingBuffer_PeekWrite(RingBuffer *rb, uint8_t **span);
+extern void RingBuffer_CommitWrite(RingBuffer *rb, uint16_t len);
+extern uint16_t RingBuffer_Write(RingBuffer *rb, const uint8_t *data, uint16_t len);
+
+static inline bool RingBuffer_PutChar(RingBuffer *rb, uint8_t c) {
+	uint16_t head = rb->head;
+
+	if ((uint16_t)(head - rb->tail) > rb->mask) {
+		return false;
+	}
+
+	rb->buf[head & rb->mask] = c;
+	RingBuffer_Barrier();
+	rb->head = head + 1;
+
+	return true;
+}
+
+// Consumer side
+extern uint16_t RingBuffer_PeekRead(RingBuffer *rb, uint8_t **span);
+extern void RingBuffer_CommitRead(RingBuffer *rb, uint16_t len);
+extern uint16_t RingBuffer_Read(RingBuffer *rb, uint8_t *data, uint16_t len);
+
+static inline int RingBuffer_GetChar(RingBuffer *rb) {
+	uint16_t tail = rb->tail;
+
+	if (rb->head == tail) {
+		return -1;
+	}
+
+	uint8_t c = rb->buf[tail & rb->mask];
+	RingBuffer_Barrier();
+	rb->tail = tail + 1;
+
+	return c;
+}
+
+#ifdef PICo24_FreeRTOS_Enabled
+extern void RingBuffer_SetRxNotify(RingBuffer *rb, TaskHandle_t task, uint16_t watermark);
+extern void RingBuffer_SetTxNotify(RingBuffer *rb, TaskHandle_t task, uint16_t watermark);
+
+// Task context wakeups
+extern void RingBuffer_NotifyRx(RingBuffer *rb);
+extern void RingBuffer_NotifyTx(RingBuffer *rb);
+
+// ISR context wakeups, call portYIELD_FROM_ISR() or similar if *woken becomes pdTRUE
+extern void RingBuffer_NotifyRxFromISR(RingBuffer *rb, BaseType_t *woken);
+extern void RingBuffer_NotifyTxFromISR(RingBuffer *rb, BaseType_t *woken);
+
+extern void RingBuffer_CommitWriteFromISR(RingBuffer *rb, uint16_t len, BaseType_t *woken);
+extern void RingBuffer_CommitReadFromISR(RingBuffer *rb, uint16_t len, BaseType_t *woken);
+extern uint16_t RingBuffer_WriteFromISR(RingBuffer *rb, const uint8_t *data, uint16_t len, BaseType_t *woken);
+extern uint16_t RingBuffer_ReadFromISR(RingBuffer *rb, uint8_t *data, uint16_t len, BaseType_t *woken);
+
+// Block the calling task until the condition holds or the timeout expires. Only one waiter per direction.
+extern bool RingBuffer_WaitReadable(RingBuffer *rb, uint16_t min_bytes, TickType_t timeout);
+extern bool RingBuffer_WaitWritable(RingBuffer *rb, uint16_t min_bytes, TickType_t timeout);
+#endif
@@ -20,7 +20,7 @@
 #include "Set.h"
 #include "Vector.h"
 
-// WIP: Now it's O(n)
+// O(n), keeps insertion order. Use SortedSet or HashSet for anything bigger than a handful of elements.
 // Thanks to MCHP for we don't have out of box C++ support
 
 bool Set_Insert(Vector *vec, const void *object) {
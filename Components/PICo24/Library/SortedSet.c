@@ -0,0 +1,123 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "SortedSet.h"
+
+static inline int SortedSet_Cmp(SortedSet *set, const void *key1, const void *key2) {
+	if (set->compare) {
+		return set->compare(key1, key2);
+	} else {
+		return memcmp(key1, key2, set->key_size);
+	}
+}
+
+void SortedSet_Init(SortedSet *set, size_t element_size) {
+	SortedSet_InitMap(set, element_size, element_size, NULL);
+}
+
+void SortedSet_InitMap(SortedSet *set, size_t element_size, size_t key_size, SortedSet_Compare compare) {
+	Vector_Init(&set->vec, element_size);
+	set->key_size = key_size;
+	set->compare = compare;
+}
+
+void SortedSet_Clear(SortedSet *set) {
+	Vector_Clear(&set->vec);
+}
+
+bool SortedSet_Reserve(SortedSet *set, size_t n) {
+	return Vector_Reserve(&set->vec, n);
+}
+
+size_t SortedSet_LowerBound(SortedSet *set, const void *key) {
+	size_t lo = 0, hi = set->vec.size;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (SortedSet_Cmp(set, Vector_At(&set->vec, mid), key) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+bool SortedSet_Insert(SortedSet *set, const void *object) {
+	size_t pos = SortedSet_LowerBound(set, object);
+
+	if (pos < set->vec.size && SortedSet_Cmp(set, Vector_At(&set->vec, pos), object) == 0) {
+		return false;
+	}
+
+	size_t items_after = set->vec.size - pos;
+
+	if (!Vector_Resize(&set->vec, set->vec.size + 1)) {
+		return false;
+	}
+
+	uint8_t *slot = Vector_At(&set->vec, pos);
+
+	if (items_after) {
+		memmove(slot + set->vec.element_size, slot, items_after * set->vec.element_size);
+	}
+
+	memcpy(slot, object, set->vec.element_size);
+
+	return true;
+}
+
+void *SortedSet_Find(SortedSet *set, const void *key) {
+	size_t pos = SortedSet_LowerBound(set, key);
+
+	if (pos < set->vec.size) {
+		void *ret = Vector_At(&set->vec, pos);
+
+		if (SortedSet_Cmp(set, ret, key) == 0) {
+			return ret;
+		}
+	}
+
+	return NULL;
+}
+
+bool SortedSet_Contains(SortedSet *set, const void *key) {
+	return SortedSet_Find(set, key) != NULL;
+}
+
+bool SortedSet_Erase(SortedSet *set, const void *key) {
+	void *it = SortedSet_Find(set, key);
+
+	if (it) {
+		Vector_Erase(&set->vec, it);
+		return true;
+	}
+
+	return false;
+}
+
+bool SortedSet_Empty(SortedSet *set) {
+	return Vector_Empty(&set->vec);
+}
+
+void *SortedSet_At(SortedSet *set, size_t pos) {
+	return Vector_At(&set->vec, pos);
+}
@@ -0,0 +1,54 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "Vector.h"
+
+// Sorted flat set on top of Vector, O(log n) lookups with binary search.
+// Only the first key_size bytes of an element are compared, so it also works as a map.
+// Elements are ordered by memcmp() unless a compare function is supplied.
+
+typedef int (*SortedSet_Compare)(const void *key1, const void *key2);
+
+typedef struct {
+	Vector vec;
+	size_t key_size;
+	SortedSet_Compare compare;
+} SortedSet;
+
+#define SortedSet_ForEach(item, set)	Vector_ForEach(item, set.vec)
+
+extern void SortedSet_Init(SortedSet *set, size_t element_size);
+extern void SortedSet_InitMap(SortedSet *set, size_t element_size, size_t key_size, SortedSet_Compare compare);
+extern void SortedSet_Clear(SortedSet *set);
+// Reserve() and Insert() return false if the storage couldn't be grown, Insert() also if the key is already present
+extern bool SortedSet_Reserve(SortedSet *set, size_t n);
+extern size_t SortedSet_LowerBound(SortedSet *set, const void *key);
+extern bool SortedSet_Insert(SortedSet *set, const void *object);
+extern void *SortedSet_Find(SortedSet *set, const void *key);
+extern bool SortedSet_Contains(SortedSet *set, const void *key);
+extern bool SortedSet_Erase(SortedSet *set, const void *key);
+extern bool SortedSet_Empty(SortedSet *set);
+extern void *SortedSet_At(SortedSet *set, size_t pos);
@@ -0,0 +1,165 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Spill.h"
+
+#include <string.h>
+#include <ScratchLibc/ScratchLibc.h>
+
+uint16_t Spill_Threshold = PICo24_Spill_Threshold;
+
+#ifdef __HAS_EDS__
+static Spill_Handle Spill_FromEDS(auto_eds void *p) {
+	return p ? (Spill_Handle)p | 1 : Spill_Null;
+}
+
+static auto_eds uint8_t *Spill_EDSPtr(Spill_Handle h) {
+	return (auto_eds uint8_t *)(h & ~(Spill_Handle)1);
+}
+#endif
+
+Spill_Handle Spill_Alloc(uint32_t size) {
+	void *p;
+
+	if (!size) {
+		return Spill_Null;
+	}
+
+#ifdef __HAS_EDS__
+	if (size >= Spill_Threshold || size > UINT16_MAX) {
+		Spill_Handle h = Spill_FromEDS(malloc_eds(size));
+
+		if (h || size > UINT16_MAX) {
+			return h;
+		}
+	}
+#else
+	if (size > UINT16_MAX) {
+		return Spill_Null;
+	}
+#endif
+
+	p = malloc(size);
+
+	if (p) {
+		return (Spill_Handle)(uintptr_t)p;
+	}
+
+#ifdef __HAS_EDS__
+	// Near heap is full, small buffers can live in EDS too
+	if (size < Spill_Threshold) {
+		return Spill_FromEDS(malloc_eds(size));
+	}
+#endif
+
+	return Spill_Null;
+}
+
+Spill_Handle Spill_Calloc(uint32_t size) {
+	Spill_Handle h = Spill_Alloc(size);
+
+	if (!h) {
+		return h;
+	}
+
+#ifdef __HAS_EDS__
+	if (Spill_IsEDS(h)) {
+		memset_eds(Spill_EDSPtr(h), 0, size);
+		return h;
+	}
+#endif
+
+	memset(Spill_NearPtr(h), 0, size);
+
+	return h;
+}
+
+void Spill_Free(Spill_Handle h) {
+	if (!h) {
+		return;
+	}
+
+#ifdef __HAS_EDS__
+	if (Spill_IsEDS(h)) {
+		free_eds(Spill_EDSPtr(h));
+		return;
+	}
+#endif
+
+	free(Spill_NearPtr(h));
+}
+
+// NULL if the buffer is in EDS
+void *Spill_NearPtr(Spill_Handle h) {
+	if (Spill_IsEDS(h)) {
+		return NULL;
+	}
+
+	return (void *)(uintptr_t)h;
+}
+
+auto_eds void *Spill_Ptr(Spill_Handle h) {
+#ifdef __HAS_EDS__
+	if (Spill_IsEDS(h)) {
+		return Spill_EDSPtr(h);
+	}
+#endif
+
+	return (auto_eds void *)Spill_NearPtr(h);
+}
+
+void Spill_Read(Spill_Handle h, uint32_t offset, void *dst, uint16_t len) {
+#ifdef __HAS_EDS__
+	if (Spill_IsEDS(h)) {
+		memcpy_eds((auto_eds void *)dst, Spill_EDSPtr(h) + offset, len);
+		return;
+	}
+#endif
+
+	memcpy(dst, (uint8_t *)Spill_NearPtr(h) + offset, len);
+}
+
+void Spill_Write(Spill_Handle h, uint32_t offset, const void *src, uint16_t len) {
+#ifdef __HAS_EDS__
+	if (Spill_IsEDS(h)) {
+		memcpy_eds(Spill_EDSPtr(h) + offset, (auto_eds const void *)src, len);
+		return;
+	}
+#endif
+
+	memcpy((uint8_t *)Spill_NearPtr(h) + offset, src, len);
+}
+
+// `window` must hold at least `len` bytes, it's only used if the buffer is in EDS
+void *Spill_Map(Spill_Handle h, uint32_t offset, uint16_t len, void *window) {
+	if (!Spill_IsEDS(h)) {
+		return (uint8_t *)Spill_NearPtr(h) + offset;
+	}
+
+	Spill_Read(h, offset, window, len);
+
+	return window;
+}
+
+// Writes the window back, not needed if nothing was modified
+void Spill_Unmap(Spill_Handle h, uint32_t offset, uint16_t len, void *mapped) {
+	if (Spill_IsEDS(h)) {
+		Spill_Write(h, offset, mapped, len);
+	}
+}
@@ -0,0 +1,66 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <PICo24/Core/IDESupport.h>
+
+/*
+ * Size based placement for large buffers. Requests of at least
+ * Spill_Threshold bytes go to the EDS heap, smaller ones to the near heap,
+ * and either falls back to the other heap when it's full. The result is a
+ * handle rather than a pointer: use Spill_Read/Spill_Write, or Spill_Map to
+ * get a near pointer, which is the buffer itself if it's in near RAM, or the
+ * caller's window with a copy of it otherwise.
+ *
+ * A handle is the address of the block with bit 0 set if it's in EDS (umm
+ * blocks are always at least 2 bytes aligned). 0 is the null handle.
+ */
+
+#ifndef PICo24_Spill_Threshold
+#define PICo24_Spill_Threshold	256
+#endif
+
+typedef uint32_t Spill_Handle;
+
+#define Spill_Null		((Spill_Handle)0)
+
+#ifdef __HAS_EDS__
+#define Spill_IsEDS(h)		((h) & 1)
+#else
+#define Spill_IsEDS(h)		0
+#endif
+
+extern uint16_t Spill_Threshold;
+
+extern Spill_Handle Spill_Alloc(uint32_t size);
+extern Spill_Handle Spill_Calloc(uint32_t size);
+extern void Spill_Free(Spill_Handle h);
+
+extern void *Spill_NearPtr(Spill_Handle h);
+extern auto_eds void *Spill_Ptr(Spill_Handle h);
+
+extern void Spill_Read(Spill_Handle h, uint32_t offset, void *dst, uint16_t len);
+extern void Spill_Write(Spill_Handle h, uint32_t offset, const void *src, uint16_t len);
+
+extern void *Spill_Map(Spill_Handle h, uint32_t offset, uint16_t len, void *window);
+extern void Spill_Unmap(Spill_Handle h, uint32_t offset, uint16_t len, void *mapped);
\ No newline at end of file
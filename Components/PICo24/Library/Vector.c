@@ -26,21 +26,80 @@ void Vector_Init(Vector *vec, size_t element_size) {
 }
 
 void Vector_Clear(Vector *vec) {
-	if (vec->size) {
+	if (vec->data) {
 		free(vec->data);
-		vec->size = 0;
 		vec->data = NULL;
 	}
+
+	vec->size = 0;
+	vec->capacity = 0;
 }
 
-void Vector_Resize(Vector *vec, size_t n) {
+void Vector_ClearKeepStorage(Vector *vec) {
+	vec->size = 0;
+}
+
+// The vector is left as it was if the allocation fails
+static bool Vector_SetCapacity(Vector *vec, size_t n) {
+	void *data;
+
 	if (vec->data) {
-		vec->data = realloc(vec->data, vec->element_size * n);
+		data = realloc(vec->data, vec->element_size * n);
+	} else {
+		data = malloc(vec->element_size * n);
+	}
+
+	if (!data) {
+		return false;
+	}
+
+	vec->data = data;
+	vec->capacity = n;
+
+	return true;
+}
+
+bool Vector_Reserve(Vector *vec, size_t n) {
+	if (n > vec->capacity) {
+		return Vector_SetCapacity(vec, n);
+	}
+
+	return true;
+}
+
+void Vector_ShrinkToFit(Vector *vec) {
+	if (vec->capacity == vec->size) {
+		return;
+	}
+
+	if (vec->size == 0) {
+		Vector_Clear(vec);
 	} else {
-		vec->data = malloc(vec->element_size * n);
+		Vector_SetCapacity(vec, vec->size);
+	}
+}
+
+bool Vector_Resize(Vector *vec, size_t n) {
+	if (n > vec->capacity) {
+		// Grow by 1.5x so a series of pushes only touches the heap O(log n) times
+		size_t new_capacity = vec->capacity + vec->capacity / 2;
+
+		if (new_capacity < Vector_MinCapacity) {
+			new_capacity = Vector_MinCapacity;
+		}
+
+		if (new_capacity < n) {
+			new_capacity = n;
+		}
+
+		if (!Vector_SetCapacity(vec, new_capacity)) {
+			return false;
+		}
 	}
 
 	vec->size = n;
+
+	return true;
 }
 
 void *Vector_At(Vector *vec, size_t pos) {
@@ -53,7 +112,10 @@ void *Vector_At(Vector *vec, size_t pos) {
 
 void *Vector_At2(Vector *vec, size_t pos) {
 	if (vec->size <= pos) {
-		Vector_Resize(vec, pos+1);
+		if (!Vector_Resize(vec, pos+1)) {
+			return NULL;
+		}
+
 		void *ret = ((uint8_t *)vec->data) + vec->element_size * pos;
 		memset(ret, 0, vec->element_size);
 		return ret;
@@ -88,24 +150,36 @@ bool Vector_Empty(Vector *vec) {
 }
 
 void *Vector_EmplaceBack(Vector *vec) {
-	Vector_Resize(vec, vec->size+1);
+	if (!Vector_Resize(vec, vec->size+1)) {
+		return NULL;
+	}
 
 	return Vector_Back(vec);
 }
 
 void *Vector_EmplaceBack2(Vector *vec, size_t len) {
 	size_t oldsize = vec->size;
-	Vector_Resize(vec, oldsize+len);
+	if (!Vector_Resize(vec, oldsize+len)) {
+		return NULL;
+	}
 
 	return Vector_At(vec, oldsize);
 }
 
 void Vector_PushBack(Vector *vec, const void *object) {
-	memcpy(Vector_EmplaceBack(vec), object, vec->element_size);
+	void *p = Vector_EmplaceBack(vec);
+
+	if (p) {
+		memcpy(p, object, vec->element_size);
+	}
 }
 
 void Vector_PushBack2(Vector *vec, const void *object, size_t len) {
-	memcpy(Vector_EmplaceBack2(vec, len), object, vec->element_size * len);
+	void *p = Vector_EmplaceBack2(vec, len);
+
+	if (p) {
+		memcpy(p, object, vec->element_size * len);
+	}
 }
 
 void Vector_Erase(Vector *vec, const void *object) {
@@ -28,16 +28,23 @@ typedef struct {
 	size_t size;
 	void *data;
 	size_t element_size;
+	size_t capacity;
 } Vector;
 
 #define Vector_Npos		(-1)
+#define Vector_MinCapacity	4
 
 #define Vector_ForEach(item, vec) \
     for (void *item=vec.data; item<(vec.data+vec.size*vec.element_size); item+=vec.element_size )
 
 extern void Vector_Init(Vector *vec, size_t element_size);
 extern void Vector_Clear(Vector *vec);
-extern void Vector_Resize(Vector *vec, size_t n);
+extern void Vector_ClearKeepStorage(Vector *vec);
+// Both return false, leaving the vector untouched, if the storage can't be grown. So do
+// At2() and the EmplaceBack()s with NULL, and the PushBack()s then add nothing.
+extern bool Vector_Resize(Vector *vec, size_t n);
+extern bool Vector_Reserve(Vector *vec, size_t n);
+extern void Vector_ShrinkToFit(Vector *vec);
 extern void *Vector_At(Vector *vec, size_t pos);
 extern void *Vector_At2(Vector *vec, size_t pos);
 extern long Vector_DistanceFromBegin(Vector *vec, const void *it);
@@ -28,21 +28,80 @@ void Vector_EDS_Init(Vector_EDS *vec, size_t element_size) {
 }
 
 void Vector_EDS_Clear(Vector_EDS *vec) {
-	if (vec->size) {
+	if (vec->data) {
 		free_eds(vec->data);
-		vec->size = 0;
 		vec->data = NULL;
 	}
+
+	vec->size = 0;
+	vec->capacity = 0;
 }
 
-void Vector_EDS_Resize(Vector_EDS *vec, size_t n) {
+void Vector_EDS_ClearKeepStorage(Vector_EDS *vec) {
+	vec->size = 0;
+}
+
+// The vector is left as it was if the allocation fails
+static bool Vector_EDS_SetCapacity(Vector_EDS *vec, size_t n) {
+	auto_eds void *data;
+
 	if (vec->data) {
-		vec->data = realloc_eds(vec->data, vec->element_size * n);
+		data = realloc_eds(vec->data, vec->element_size * n);
+	} else {
+		data = malloc_eds(vec->element_size * n);
+	}
+
+	if (!data) {
+		return false;
+	}
+
+	vec->data = data;
+	vec->capacity = n;
+
+	return true;
+}
+
+bool Vector_EDS_Reserve(Vector_EDS *vec, size_t n) {
+	if (n > vec->capacity) {
+		return Vector_EDS_SetCapacity(vec, n);
+	}
+
+	return true;
+}
+
+void Vector_EDS_ShrinkToFit(Vector_EDS *vec) {
+	if (vec->capacity == vec->size) {
+		return;
+	}
+
+	if (vec->size == 0) {
+		Vector_EDS_Clear(vec);
 	} else {
-		vec->data = malloc_eds(vec->element_size * n);
+		Vector_EDS_SetCapacity(vec, vec->size);
+	}
+}
+
+bool Vector_EDS_Resize(Vector_EDS *vec, size_t n) {
+	if (n > vec->capacity) {
+		// Grow by 1.5x so a series of pushes only touches the heap O(log n) times
+		size_t new_capacity = vec->capacity + vec->capacity / 2;
+
+		if (new_capacity < Vector_EDS_MinCapacity) {
+			new_capacity = Vector_EDS_MinCapacity;
+		}
+
+		if (new_capacity < n) {
+			new_capacity = n;
+		}
+
+		if (!Vector_EDS_SetCapacity(vec, new_capacity)) {
+			return false;
+		}
 	}
 
 	vec->size = n;
+
+	return true;
 }
 
 auto_eds void *Vector_EDS_At(Vector_EDS *vec, size_t pos) {
@@ -55,7 +114,10 @@ auto_eds void *Vector_EDS_At(Vector_EDS *vec, size_t pos) {
 
 auto_eds void *Vector_EDS_At2(Vector_EDS *vec, size_t pos) {
 	if (vec->size <= pos) {
-		Vector_EDS_Resize(vec, pos+1);
+		if (!Vector_EDS_Resize(vec, pos+1)) {
+			return NULL;
+		}
+
 		auto_eds void *ret = ((auto_eds uint8_t *)vec->data) + vec->element_size * pos;
 		memset_eds(ret, 0, vec->element_size);
 		return ret;
@@ -90,24 +152,36 @@ bool Vector_EDS_Empty(Vector_EDS *vec) {
 }
 
 auto_eds void *Vector_EDS_EmplaceBack(Vector_EDS *vec) {
-	Vector_EDS_Resize(vec, vec->size+1);
+	if (!Vector_EDS_Resize(vec, vec->size+1)) {
+		return NULL;
+	}
 
 	return Vector_EDS_Back(vec);
 }
 
 auto_eds void *Vector_EDS_EmplaceBack2(Vector_EDS *vec, size_t len) {
 	size_t oldsize = vec->size;
-	Vector_EDS_Resize(vec, oldsize+len);
+	if (!Vector_EDS_Resize(vec, oldsize+len)) {
+		return NULL;
+	}
 
 	return Vector_EDS_At(vec, oldsize);
 }
 
 void Vector_EDS_PushBack(Vector_EDS *vec, auto_eds const void *object) {
-	memcpy_eds(Vector_EDS_EmplaceBack(vec), object, vec->element_size);
+	auto_eds void *p = Vector_EDS_EmplaceBack(vec);
+
+	if (p) {
+		memcpy_eds(p, object, vec->element_size);
+	}
 }
 
 void Vector_EDS_PushBack2(Vector_EDS *vec, auto_eds const void *object, size_t len) {
-	memcpy_eds(Vector_EDS_EmplaceBack2(vec, len), object, vec->element_size * len);
+	auto_eds void *p = Vector_EDS_EmplaceBack2(vec, len);
+
+	if (p) {
+		memcpy_eds(p, object, vec->element_size * len);
+	}
 }
 
 void Vector_EDS_Erase(Vector_EDS *vec, auto_eds const void *object) {
@@ -32,16 +32,22 @@ typedef struct {
 	size_t size;
 	auto_eds void *data;
 	size_t element_size;
+	size_t capacity;
 } Vector_EDS;
 
 #define Vector_EDS_Npos		(-1)
+#define Vector_EDS_MinCapacity	4
 
 #define Vector_EDS_ForEach(item, vec) \
     for (auto_eds void *item=vec.data; item<(vec.data+vec.size*vec.element_size); item+=vec.element_size )
 
 void Vector_EDS_Init(Vector_EDS *vec, size_t element_size);
 void Vector_EDS_Clear(Vector_EDS *vec);
-void Vector_EDS_Resize(Vector_EDS *vec, size_t n);
+void Vector_EDS_ClearKeepStorage(Vector_EDS *vec);
+// See Vector.h for what happens when the storage can't be grown
+bool Vector_EDS_Resize(Vector_EDS *vec, size_t n);
+bool Vector_EDS_Reserve(Vector_EDS *vec, size_t n);
+void Vector_EDS_ShrinkToFit(Vector_EDS *vec);
 auto_eds void *Vector_EDS_At(Vector_EDS *vec, size_t pos);
 auto_eds void *Vector_EDS_At2(Vector_EDS *vec, size_t pos);
 long Vector_EDS_DistanceFromBegin(Vector_EDS *vec, auto_eds const void *it);
@@ -58,11 +64,15 @@ long Vector_EDS_Find(Vector_EDS *vec, auto_eds const void *object);
 #else
 
 #define Vector_EDS_Npos			Vector_Npos
+#define Vector_EDS_MinCapacity		Vector_MinCapacity
 #define Vector_EDS_ForEach(item, vec)	Vector_ForEach(item, vec)
 
 #define Vector_EDS_Init			Vector_Init
 #define Vector_EDS_Clear		Vector_Clear
+#define Vector_EDS_ClearKeepStorage	Vector_ClearKeepStorage
 #define Vector_EDS_Resize		Vector_Resize
+#define Vector_EDS_Reserve		Vector_Reserve
+#define Vector_EDS_ShrinkToFit		Vector_ShrinkToFit
 #define Vector_EDS_At			Vector_At
 #define Vector_EDS_At2			Vector_At2
 #define Vector_EDS_DistanceFromBegin	Vector_DistanceFromBegin
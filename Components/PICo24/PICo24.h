@@ -22,12 +22,24 @@
 #include <PICo24/Core/Core.h>
 #include <PICo24/Core/IDESupport.h>
 #include <PICo24/Core/Delay.h>
+#include <PICo24/Core/Timebase.h>
+#include <PICo24/Core/Deferred.h>
+#include <PICo24/Core/Latency.h>
+#include <PICo24/Core/Trace.h>
+#include <PICo24/Core/Profiler.h>
+#include <PICo24/Core/StackAudit.h>
 
 #include <PICo24/Library/Variant.h>
 #include <PICo24/Library/Vector.h>
 #include <PICo24/Library/Vector_EDS.h>
 #include <PICo24/Library/Set.h>
+#include <PICo24/Library/HashSet.h>
+#include <PICo24/Library/SortedSet.h>
+#include <PICo24/Library/RingBuffer.h>
 #include <PICo24/Library/SafeMalloc.h>
+#include <PICo24/Library/Pool.h>
+#include <PICo24/Library/Pool_EDS.h>
+#include <PICo24/Library/Spill.h>
 #include <PICo24/Library/DebugTools.h>
 
 
@@ -36,6 +48,8 @@
 #include <PICo24/Peripherals/I2C/I2C.h>
 #include <PICo24/Peripherals/EXT_INT/EXT_INT.h>
 #include <PICo24/Peripherals/Timer/Timer.h>
+#include <PICo24/Peripherals/Timer/Alarm.h>
+#include <PICo24/Peripherals/DMA/DMA.h>
 #include <PICo24/Peripherals/USB/usb_deluxe.h>
 
 #include <PICo24/UnixAPI/mini_unistd.h>
@@ -0,0 +1,376 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "DMA.h"
+
+#ifdef PICo24_Enable_Peripheral_DMA
+
+#include <xc.h>
+
+#include <PICo24/Core/Delay.h>
+#include <PICo24/Core/FreeRTOS_Support.h>
+#include <ScratchLibc/ScratchLibc.h>
+
+#ifdef _DMA0IF
+
+typedef struct {
+	void (*Callback)(void *userp, uint8_t events);
+	void *UserP;
+#ifdef PICo24_FreeRTOS_Enabled
+	volatile TaskHandle_t waiter;
+#endif
+	volatile bool done;
+	bool used;
+} DMA_ChannelState;
+
+static DMA_ChannelState dma_channels[PICo24_DMA_Channels];
+
+static void DMA_SetIRQ(uint8_t ch, bool enabled) {
+	switch (ch) {
+		case 0:
+			_DMA0IF = 0;
+			_DMA0IE = enabled;
+			break;
+		case 1:
+			_DMA1IF = 0;
+			_DMA1IE = enabled;
+			break;
+		case 2:
+			_DMA2IF = 0;
+			_DMA2IE = enabled;
+			break;
+		case 3:
+			_DMA3IF = 0;
+			_DMA3IE = enabled;
+			break;
+		case 4:
+			_DMA4IF = 0;
+			_DMA4IE = enabled;
+			break;
+		case 5:
+			_DMA5IF = 0;
+			_DMA5IE = enabled;
+			break;
+		default:
+			break;
+	}
+}
+
+void DMA_Initialize() {
+	DMACON = 0;
+	DMAL = PICo24_DMA_Low;
+	DMAH = PICo24_DMA_High;
+
+	for (uint8_t i=0; i<PICo24_DMA_Channels; i++) {
+		*(uint16_t *)hdma[i].CH = 0;
+		*(uint16_t *)hdma[i].INT = 0;
+		DMA_SetIRQ(i, false);
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	_DMA0IP = _DMA1IP = _DMA2IP = _DMA3IP = _DMA4IP = _DMA5IP = configKERNEL_INTERRUPT_PRIORITY;
+#endif
+
+	// Fixed priority, lower channels first
+	DMACONbits.DMAEN = 1;
+}
+
+bool DMA_Available() {
+	return true;
+}
+
+static int8_t DMA_Claim(void (*callback)(void *userp, uint8_t events), void *userp, bool irq) {
+	uint16_t ipl;
+	int8_t ch = -1;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	for (uint8_t i=0; i<PICo24_DMA_Channels; i++) {
+		if (!dma_channels[i].used) {
+			dma_channels[i].used = true;
+			ch = i;
+			break;
+		}
+	}
+	RESTORE_CPU_IPL(ipl);
+
+	if (ch >= 0) {
+		dma_channels[ch].Callback = callback;
+		dma_channels[ch].UserP = userp;
+		DMA_SetIRQ(ch, irq);
+	}
+
+	return ch;
+}
+
+int8_t DMA_Allocate(void (*callback)(void *userp, uint8_t events), void *userp) {
+	return DMA_Claim(callback, userp, true);
+}
+
+void DMA_Free(int8_t ch) {
+	if (ch < 0 || ch >= PICo24_DMA_Channels) {
+		return;
+	}
+
+	DMA_Disable(ch);
+	DMA_SetIRQ(ch, false);
+	dma_channels[ch].Callback = NULL;
+	dma_channels[ch].used = false;
+}
+
+void DMA_Setup(int8_t ch, uint8_t flags, uint8_t trigger, volatile const void *src, volatile void *dst, uint16_t count) {
+	const DMA_HandleTypeDef *h = &hdma[ch];
+	DMACHBITS c = {0};
+	DMAINTBITS i = {0};
+
+	h->CH->CHEN = 0;
+
+	c.SIZE = (flags & DMA_BYTE) ? 1 : 0;
+	c.SAMODE = (flags & DMA_SRC_INC) ? 1 : 0;
+	c.DAMODE = (flags & DMA_DST_INC) ? 1 : 0;
+	c.TRMODE = ((flags & DMA_BLOCK) ? 2 : 0) | ((flags & DMA_REPEAT) ? 1 : 0);
+	c.RELOAD = (flags & DMA_REPEAT) ? 1 : 0;
+
+	i.CHSEL = trigger;
+	i.HALFEN = (flags & DMA_HALF) ? 1 : 0;
+
+	*h->SRC = (uint16_t)src;
+	*h->DST = (uint16_t)dst;
+	*h->CNT = count;
+	*h->INT = i;
+	*h->CH = c;
+}
+
+void DMA_Enable(int8_t ch) {
+	dma_channels[ch].done = false;
+	hdma[ch].CH->CHEN = 1;
+}
+
+void DMA_Disable(int8_t ch) {
+	hdma[ch].CH->CHEN = 0;
+}
+
+void DMA_Request(int8_t ch) {
+	hdma[ch].CH->CHREQ = 1;
+}
+
+uint16_t DMA_Remaining(int8_t ch) {
+	return *hdma[ch].CNT;
+}
+
+uint16_t DMA_CurrentSource(int8_t ch) {
+	return *hdma[ch].SRC;
+}
+
+uint16_t DMA_CurrentDestination(int8_t ch) {
+	return *hdma[ch].DST;
+}
+
+bool DMA_Wait(int8_t ch, uint32_t timeout_ms) {
+	DMA_ChannelState *s = &dma_channels[ch];
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (freertos_started) {
+		TickType_t timeout = (timeout_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+		TickType_t start = xTaskGetTickCount();
+
+		s->waiter = xTaskGetCurrentTaskHandle();
+
+		// The notification slot is shared with other wakers (USB, RingBuffer, ...), so only
+		// the done flag or the deadline ends the wait
+		while (!s->done) {
+			TickType_t waited = xTaskGetTickCount() - start;
+
+			if (timeout_ms && waited >= timeout) {
+				break;
+			}
+
+			ulTaskNotifyTake(pdTRUE, timeout_ms ? timeout - waited : portMAX_DELAY);
+		}
+
+		s->waiter = NULL;
+
+		return s->done;
+	}
+#endif
+
+	for (uint32_t waited=0; !s->done; waited++) {
+		if (timeout_ms && waited >= timeout_ms) {
+			return false;
+		}
+
+		Delay_Milliseconds(1);
+	}
+
+	return true;
+}
+
+void DMA_SetMemcpyOffload(bool enabled) {
+#ifdef __HAS_EDS__
+	memcpy_near_offload = enabled ? DMA_Memcpy : NULL;
+#endif
+}
+
+bool DMA_Memcpy(void *dest, const void *src, uint16_t len) {
+	if (len < PICo24_DMA_MemcpyMin) {
+		return false;
+	}
+
+	// Polled, so it also works with interrupts masked
+	int8_t ch = DMA_Claim(NULL, NULL, false);
+
+	if (ch < 0) {
+		return false;
+	}
+
+	bool words = !(((uint16_t)dest | (uint16_t)src) & 1);
+	uint16_t count = words ? len >> 1 : len;
+
+	volatile DMAINTBITS *i = hdma[ch].INT;
+	// Far more than a block takes, only there so a stuck channel can't hang the caller
+	uint32_t spins = (uint32_t)count * 16 + 256;
+	bool done;
+
+	DMA_Setup(ch, (words ? 0 : DMA_BYTE) | DMA_SRC_INC | DMA_DST_INC | DMA_BLOCK, DMA_TRIGGER_NONE, src, dest, count);
+	DMA_Enable(ch);
+	DMA_Request(ch);
+
+	// Outside PICo24_DMA_Low/High the channel stops without ever setting DONEIF
+	while (!(done = i->DONEIF) && !i->HIGHIF && !i->LOWIF && --spins) {
+	}
+
+	i->DONEIF = 0;
+	i->HIGHIF = 0;
+	i->LOWIF = 0;
+	DMA_Free(ch);
+
+	// The source is untouched, so the CPU can simply do the whole copy again
+	if (!done) {
+		return false;
+	}
+
+	if (words && (len & 1)) {
+		((uint8_t *)dest)[len - 1] = ((const uint8_t *)src)[len - 1];
+	}
+
+	return true;
+}
+
+void DMA_ProcessInterrupt(uint8_t ch) {
+	volatile DMAINTBITS *i = hdma[ch].INT;
+	DMA_ChannelState *s = &dma_channels[ch];
+	uint8_t events = 0;
+
+	if (i->DONEIF) {
+		i->DONEIF = 0;
+		events |= DMA_EVENT_DONE;
+		s->done = true;
+	}
+
+	if (i->HALFIF) {
+		i->HALFIF = 0;
+		events |= DMA_EVENT_HALF;
+	}
+
+	if (i->OVRUNIF) {
+		i->OVRUNIF = 0;
+		events |= DMA_EVENT_OVERRUN;
+	}
+
+	if (i->HIGHIF || i->LOWIF) {
+		i->HIGHIF = 0;
+		i->LOWIF = 0;
+		events |= DMA_EVENT_ADDRESS;
+	}
+
+	if (s->Callback) {
+		s->Callback(s->UserP, events);
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if ((events & DMA_EVENT_DONE) && s->waiter) {
+		BaseType_t woken = pdFALSE;
+
+		vTaskNotifyGiveFromISR(s->waiter, &woken);
+
+		if (woken && freertos_started) {
+			taskYIELD();
+		}
+	}
+#endif
+}
+
+#else
+
+// No DMA controller on this device, everything takes the CPU paths
+
+void DMA_Initialize() {
+}
+
+bool DMA_Available() {
+	return false;
+}
+
+int8_t DMA_Allocate(void (*callback)(void *userp, uint8_t events), void *userp) {
+	return -1;
+}
+
+void DMA_Free(int8_t ch) {
+}
+
+void DMA_Setup(int8_t ch, uint8_t flags, uint8_t trigger, volatile const void *src, volatile void *dst, uint16_t count) {
+}
+
+void DMA_Enable(int8_t ch) {
+}
+
+void DMA_Disable(int8_t ch) {
+}
+
+void DMA_Request(int8_t ch) {
+}
+
+uint16_t DMA_Remaining(int8_t ch) {
+	return 0;
+}
+
+uint16_t DMA_CurrentSource(int8_t ch) {
+	return 0;
+}
+
+uint16_t DMA_CurrentDestination(int8_t ch) {
+	return 0;
+}
+
+bool DMA_Wait(int8_t ch, uint32_t timeout_ms) {
+	return true;
+}
+
+void DMA_SetMemcpyOffload(bool enabled) {
+}
+
+bool DMA_Memcpy(void *dest, const void *src, uint16_t len) {
+	return false;
+}
+
+void DMA_ProcessInterrupt(uint8_t ch) {
+}
+
+#endif
+
+#endif
@@ -0,0 +1,152 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef PICo24_Enable_Peripheral_DMA
+
+/*
+ * DMA channel allocator and driver, for the PIC24FJ devices that have the
+ * controller (e.g. the GB2 family). The board defines hdma[] and calls
+ * DMA_ProcessInterrupt() from the channel interrupts, which run at the
+ * kernel priority, so callbacks may use the FromISR APIs.
+ *
+ * On devices without it DMA_Allocate() always fails and callers keep to
+ * their CPU loops. Channels only reach the 16-bit data space, not EDS
+ * pages.
+ */
+
+#ifndef PICo24_DMA_Channels
+#define PICo24_DMA_Channels		6
+#endif
+
+// Near RAM the channels may touch, anything else raises DMA_EVENT_ADDRESS
+#ifndef PICo24_DMA_Low
+#define PICo24_DMA_Low			0x0800
+#endif
+
+#ifndef PICo24_DMA_High
+#define PICo24_DMA_High			0x7fff
+#endif
+
+// Shorter copies aren't worth setting up a channel for
+#ifndef PICo24_DMA_MemcpyMin
+#define PICo24_DMA_MemcpyMin		64
+#endif
+
+typedef union {
+	struct {
+		uint16_t CHEN:1;
+		uint16_t SIZE:1;
+		uint16_t TRMODE:2;
+		uint16_t DAMODE:2;
+		uint16_t SAMODE:2;
+		uint16_t CHREQ:1;
+		uint16_t RELOAD:1;
+		uint16_t NULLW:1;
+		uint16_t :5;
+	};
+	struct {
+		uint16_t :2;
+		uint16_t TRMODE0:1;
+		uint16_t TRMODE1:1;
+	};
+} DMACHBITS;
+
+typedef union {
+	struct {
+		uint16_t HALFEN:1;
+		uint16_t :2;
+		uint16_t OVRUNIF:1;
+		uint16_t HALFIF:1;
+		uint16_t DONEIF:1;
+		uint16_t LOWIF:1;
+		uint16_t HIGHIF:1;
+		uint16_t CHSEL:7;
+		uint16_t DBUFWF:1;
+	};
+} DMAINTBITS;
+
+typedef struct {
+	volatile DMACHBITS *CH;
+	volatile DMAINTBITS *INT;
+	volatile uint16_t *SRC;
+	volatile uint16_t *DST;
+	volatile uint16_t *CNT;
+} DMA_HandleTypeDef;
+
+extern const DMA_HandleTypeDef hdma[PICo24_DMA_Channels];
+
+// Trigger sources are the peripherals' IRQ numbers, kept in their handles
+enum {
+	DMA_TRIGGER_NONE = 0x0,		// Only DMA_Request() moves the channel
+};
+
+enum {
+	DMA_BYTE = 0x1,		// Otherwise words
+	DMA_SRC_INC = 0x2,
+	DMA_DST_INC = 0x4,
+	DMA_BLOCK = 0x8,	// The whole count on one trigger, otherwise one transfer per trigger
+	DMA_REPEAT = 0x10,	// Reload the addresses and the count when done, and keep going
+	DMA_HALF = 0x20,	// Also report DMA_EVENT_HALF
+};
+
+enum {
+	DMA_EVENT_DONE = 0x1,
+	DMA_EVENT_HALF = 0x2,
+	DMA_EVENT_OVERRUN = 0x4,	// A trigger came before the last one was served
+	DMA_EVENT_ADDRESS = 0x8,	// Tried to go outside PICo24_DMA_Low/High
+};
+
+extern void DMA_Initialize();
+extern bool DMA_Available();
+
+// Returns the channel, or -1 if none is free (or there's no DMA at all)
+extern int8_t DMA_Allocate(void (*callback)(void *userp, uint8_t events), void *userp);
+extern void DMA_Free(int8_t ch);
+
+// count is in transfers of the chosen size. The channel is left disabled
+extern void DMA_Setup(int8_t ch, uint8_t flags, uint8_t trigger, volatile const void *src, volatile void *dst, uint16_t count);
+extern void DMA_Enable(int8_t ch);
+extern void DMA_Disable(int8_t ch);
+// One transfer, or the whole block with DMA_BLOCK, without waiting for the trigger
+extern void DMA_Request(int8_t ch);
+
+extern uint16_t DMA_Remaining(int8_t ch);
+// Where the next transfer reads from and writes to
+extern uint16_t DMA_CurrentSource(int8_t ch);
+extern uint16_t DMA_CurrentDestination(int8_t ch);
+
+// Waits for DMA_EVENT_DONE since the last DMA_Enable(), 0 waits forever
+extern bool DMA_Wait(int8_t ch, uint32_t timeout_ms);
+
+// Blocking copy in near RAM, polled so it works with interrupts masked. Returns false if it's too short,
+// no channel is free, or the channel hit an address error or didn't finish in time; the caller then
+// copies with the CPU. The CPU spins while the channel copies, so this saves no CPU time.
+extern bool DMA_Memcpy(void *dest, const void *src, uint16_t len);
+// Off by default: hands memcpy_eds() chunks in near RAM to DMA_Memcpy(). Every such copy, from any
+// task or ISR, then briefly takes a channel that SPI or UART transfers may be waiting for.
+extern void DMA_SetMemcpyOffload(bool enabled);
+
+extern void DMA_ProcessInterrupt(uint8_t ch);
+
+#endif
\ No newline at end of file
@@ -21,6 +21,13 @@
 #include "SPI.h"
 
 #ifdef PICo24_Enable_Peripheral_SPI
+
+#include <xc.h>
+
+#ifdef PICo24_Enable_Peripheral_DMA
+#include <PICo24/Core/FreeRTOS_Support.h>
+#include <PICo24/Peripherals/DMA/DMA.h>
+#endif
 void SPI_Initialize(const SPI_HandleTypeDef *hspi, uint16_t spi_mode) {
 	volatile SPICON1BITS *con1 = hspi->CON1;
 
@@ -80,41 +87,42 @@ void SPI_Disable(const SPI_HandleTypeDef *hspi) {
 	hspi->STAT->SPIEN = 0;
 }
 
-uint16_t SPI_TransmitReceive(const SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size) {
+// At most this many bytes (or words) are in flight: everything fits in the TX FIFO, and the RX FIFO
+// can't overflow since nothing more goes out before the answers are read. Filling by count also
+// keeps us away from SPITBF and SPIBEC, which are unreliable on the PIC24FJ64GB004.
+#define SPI_FIFO_DEPTH		8
+
+static void SPI_Flush(const SPI_HandleTypeDef *hspi) {
+	// Leftovers would be taken as our answers and throw the count off
+	while (hspi->STAT->SRXMPT == 0) {
+		PICo24_Discard16 = *hspi->BUF;
+	}
+
+	hspi->STAT->SPIROV = 0;
+}
+
+static uint16_t SPI_Burst(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, uint8_t fill) {
+	volatile SPISTATBITS *stat = hspi->STAT;
+	volatile uint16_t *buf = hspi->BUF;
 	uint16_t dataSentCount = 0;
 	uint16_t dataReceivedCount = 0;
-	uint16_t dummyDataReceived = 0;
-	uint16_t dummyDataTransmit = 0;
 
-	uint8_t *pSend, *pReceived;
-	uint16_t addressIncrement;
-	uint16_t receiveAddressIncrement, sendAddressIncrement;
+	SPI_Flush(hspi);
 
-	addressIncrement = 1;
-
-	if (pTxData == NULL) {
-		sendAddressIncrement = 0;
-		pSend = (uint8_t*)&dummyDataTransmit;
-	} else {
-		sendAddressIncrement = addressIncrement;
-		pSend = (uint8_t*)pTxData;
-	}
+	while (dataReceivedCount < Size) {
+		uint16_t n = SPI_FIFO_DEPTH - (dataSentCount - dataReceivedCount);
 
-	if (pRxData == NULL) {
-		receiveAddressIncrement = 0;
-		pReceived = (uint8_t*)&dummyDataReceived;
-	} else {
-		receiveAddressIncrement = addressIncrement;
-		pReceived = (uint8_t*)pRxData;
-	}
+		if (n > Size - dataSentCount)
+			n = Size - dataSentCount;
 
-	while (dataSentCount < Size) {
-		// Workaround for PIC24FJ64GB004 SPITBF bugs
-		if (hspi->STAT->SPIBEC != 7) {
-			*hspi->BUF = *pSend;
+		dataSentCount += n;
 
-			pSend += sendAddressIncrement;
-			dataSentCount++;
+		if (pTxData) {
+			for (; n; n--)
+				*buf = *pTxData++;
+		} else {
+			for (; n; n--)
+				*buf = fill;
 		}
 
 		// Reimu 20210525:
@@ -125,162 +133,383 @@ uint16_t SPI_TransmitReceive(const SPI_HandleTypeDef *hspi, uint8_t *pTxData, ui
 		// Someone noticed this behavior as well, but it remained a mystery for them.
 		// https://electronics.stackexchange.com/questions/296086/pic24f-mplab-x-mcc-microchip-code-configurator-spi-driver-issue
 		// Don't make your code quality the same as Windows 10, dear MCHP.
-		while (hspi->STAT->SRXMPT == 0) {
-			*pReceived = *hspi->BUF;
-
-			pReceived += receiveAddressIncrement;
-			dataReceivedCount++;
+		if (pRxData) {
+			while (stat->SRXMPT == 0) {
+				*pRxData++ = *buf;
+				dataReceivedCount++;
+			}
+		} else {
+			while (stat->SRXMPT == 0) {
+				PICo24_Discard16 = *buf;
+				dataReceivedCount++;
+			}
 		}
-
 	}
 
-	while (dataReceivedCount < Size) {
-		if (hspi->STAT->SRXMPT == 0) {
+	return dataSentCount;
+}
+
+static uint16_t SPI_Burst16(const SPI_HandleTypeDef *hspi, const uint16_t *pTxData, uint16_t *pRxData, uint16_t Count, uint16_t fill) {
+	volatile SPISTATBITS *stat = hspi->STAT;
+	volatile uint16_t *buf = hspi->BUF;
+	uint16_t dataSentCount = 0;
+	uint16_t dataReceivedCount = 0;
+
+	SPI_Flush(hspi);
+
+	while (dataReceivedCount < Count) {
+		uint16_t n = SPI_FIFO_DEPTH - (dataSentCount - dataReceivedCount);
+
+		if (n > Count - dataSentCount)
+			n = Count - dataSentCount;
 
-			*pReceived = *hspi->BUF;
+		dataSentCount += n;
 
-			pReceived += receiveAddressIncrement;
-			dataReceivedCount++;
+		if (pTxData) {
+			for (; n; n--)
+				*buf = *pTxData++;
+		} else {
+			for (; n; n--)
+				*buf = fill;
+		}
+
+		if (pRxData) {
+			while (stat->SRXMPT == 0) {
+				*pRxData++ = *buf;
+				dataReceivedCount++;
+			}
+		} else {
+			while (stat->SRXMPT == 0) {
+				PICo24_Discard16 = *buf;
+				dataReceivedCount++;
+			}
 		}
 	}
 
 	return dataSentCount;
 }
 
+uint16_t SPI_TransmitReceive(const SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size) {
+	return SPI_Burst(hspi, pTxData, pRxData, Size, 0);
+}
 
 uint16_t SPI_Transmit(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint16_t Size) {
-	// A trimmed version to make TX only operations faster.
+	return SPI_Burst(hspi, pTxData, NULL, Size, 0);
+}
+
+uint16_t SPI_Receive(const SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size) {
+	return SPI_Burst(hspi, NULL, pRxData, Size, 0);
+}
 
+uint16_t SPI_ReceiveFill(const SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size, uint8_t fill) {
+	return SPI_Burst(hspi, NULL, pRxData, Size, fill);
+}
+
+uint16_t SPI_Fill(const SPI_HandleTypeDef *hspi, uint8_t pattern, uint16_t Size) {
+	return SPI_Burst(hspi, NULL, NULL, Size, pattern);
+}
+
+uint16_t SPI_TransmitReceive16(const SPI_HandleTypeDef *hspi, const uint16_t *pTxData, uint16_t *pRxData, uint16_t Count) {
+	return SPI_Burst16(hspi, pTxData, pRxData, Count, 0);
+}
+
+uint16_t SPI_Transmit16(const SPI_HandleTypeDef *hspi, const uint16_t *pTxData, uint16_t Count) {
+	return SPI_Burst16(hspi, pTxData, NULL, Count, 0);
+}
+
+uint16_t SPI_Receive16(const SPI_HandleTypeDef *hspi, uint16_t *pRxData, uint16_t Count) {
+	return SPI_Burst16(hspi, NULL, pRxData, Count, 0);
+}
+
+uint16_t SPI_Fill16(const SPI_HandleTypeDef *hspi, uint16_t pattern, uint16_t Count) {
+	return SPI_Burst16(hspi, NULL, NULL, Count, pattern);
+}
+
+uint16_t SPI_TransmitReceiveWords(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size) {
+	volatile SPISTATBITS *stat = hspi->STAT;
+	volatile uint16_t *buf = hspi->BUF;
 	uint16_t dataSentCount = 0;
 	uint16_t dataReceivedCount = 0;
 
-	while (dataSentCount < Size) {
-		if (hspi->STAT->SPIBEC != 7) {
-			*hspi->BUF = *pTxData;
-			pTxData += 1;
-			dataSentCount++;
-		}
+	if (!hspi->CON1->MODE16 || (Size & 1))
+		return SPI_TransmitReceive(hspi, (uint8_t *)pTxData, pRxData, Size);
 
-		while (hspi->STAT->SRXMPT == 0) {
-			PICo24_Discard16 = *hspi->BUF;
-			dataReceivedCount++;
-		}
-	}
+	// Two bytes per FIFO slot, the first one in the high half so the wire order doesn't change
+	Size >>= 1;
+
+	SPI_Flush(hspi);
 
 	while (dataReceivedCount < Size) {
-		if (hspi->STAT->SRXMPT == 0) {
-			PICo24_Discard16 = *hspi->BUF;
-			dataReceivedCount++;
+		uint16_t n = SPI_FIFO_DEPTH - (dataSentCount - dataReceivedCount);
+
+		if (n > Size - dataSentCount)
+			n = Size - dataSentCount;
+
+		dataSentCount += n;
+
+		if (pTxData) {
+			for (; n; n--) {
+				*buf = ((uint16_t)pTxData[0] << 8) | pTxData[1];
+				pTxData += 2;
+			}
+		} else {
+			for (; n; n--)
+				*buf = 0;
+		}
+
+		if (pRxData) {
+			while (stat->SRXMPT == 0) {
+				uint16_t w = *buf;
+
+				pRxData[0] = w >> 8;
+				pRxData[1] = w;
+				pRxData += 2;
+				dataReceivedCount++;
+			}
+		} else {
+			while (stat->SRXMPT == 0) {
+				PICo24_Discard16 = *buf;
+				dataReceivedCount++;
+			}
 		}
 	}
 
-	return dataSentCount;
+	return dataSentCount << 1;
 }
 
-uint16_t SPI_Receive(const SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size) {
-	return SPI_TransmitReceive(hspi, NULL, pRxData, Size);
+#ifdef PICo24_Enable_Peripheral_DMA
+typedef struct {
+	const SPI_HandleTypeDef *hspi;
+	void (*Callback)(void *userp);
+	void *UserP;
+#ifdef PICo24_FreeRTOS_Enabled
+	volatile TaskHandle_t waiter;
+#endif
+	int8_t rx_ch;
+	int8_t tx_ch;
+	uint8_t sisel;
+	volatile bool busy;
+	// Stand in for a missing buffer, the addresses don't move. Nothing writes to fill,
+	// it stays 0 like in SPI_Receive(), and sink takes what TX only transfers receive
+	uint8_t sink;
+	uint8_t fill;
+} SPI_DMAState;
+
+static SPI_DMAState spi_dma[3];
+
+static SPI_DMAState *SPI_GetDMAState(const SPI_HandleTypeDef *hspi) {
+	uint8_t i;
+
+	if (hspi->STAT == (volatile SPISTATBITS *)&SPI1STAT) {
+		i = 0;
+	} else if (hspi->STAT == (volatile SPISTATBITS *)&SPI2STAT) {
+		i = 1;
+#ifdef _SPI3IF
+	} else if (hspi->STAT == (volatile SPISTATBITS *)&SPI3STAT) {
+		i = 2;
+#endif
+	} else {
+		return NULL;
+	}
+
+	spi_dma[i].hspi = hspi;
+
+	return &spi_dma[i];
 }
 
-#ifdef __HAS_EDS__
-uint16_t SPI_TransmitReceive_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pTxData, auto_eds uint8_t *pRxData, uint16_t Size) {
-	uint16_t dataSentCount = 0;
-	uint16_t dataReceivedCount = 0;
-	uint16_t dummyDataReceived = 0;
-	uint16_t dummyDataTransmit = 0;
+static void SPI_DMADone(void *userp, uint8_t events) {
+	SPI_DMAState *s = userp;
+
+	if (!(events & DMA_EVENT_DONE)) {
+		return;
+	}
 
-	auto_eds uint8_t *pSend, *pReceived;
-	uint16_t addressIncrement;
-	uint16_t receiveAddressIncrement, sendAddressIncrement;
+	s->hspi->STAT->SISEL = s->sisel;
 
-	addressIncrement = 1;
+	DMA_Free(s->tx_ch);
+	DMA_Free(s->rx_ch);
+	s->busy = false;
 
-	if (pTxData == NULL) {
-		sendAddressIncrement = 0;
-		pSend = (auto_eds uint8_t*)&dummyDataTransmit;
-	} else {
-		sendAddressIncrement = addressIncrement;
-		pSend = (auto_eds uint8_t*)pTxData;
+	if (s->Callback) {
+		s->Callback(s->UserP);
 	}
 
-	if (pRxData == NULL) {
-		receiveAddressIncrement = 0;
-		pReceived = (auto_eds uint8_t*)&dummyDataReceived;
-	} else {
-		receiveAddressIncrement = addressIncrement;
-		pReceived = (auto_eds uint8_t*)pRxData;
+#ifdef PICo24_FreeRTOS_Enabled
+	if (s->waiter) {
+		BaseType_t woken = pdFALSE;
+
+		vTaskNotifyGiveFromISR(s->waiter, &woken);
+
+		if (woken && freertos_started) {
+			taskYIELD();
+		}
 	}
+#endif
+}
 
-	while (dataSentCount < Size) {
-		// Workaround for PIC24FJ64GB004 SPITBF bugs
-		if (hspi->STAT->SPIBEC != 7) {
-			*hspi->BUF = *pSend;
+bool SPI_TransmitReceive_DMA(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, void (*callback)(void *userp), void *userp) {
+	SPI_DMAState *s = SPI_GetDMAState(hspi);
 
-			pSend += sendAddressIncrement;
-			dataSentCount++;
+	if (s && s->busy) {
+		return false;
+	}
+
+	int8_t rx_ch = -1, tx_ch = -1;
+
+	if (s && hspi->DMA_TRIGGER && Size) {
+		s->busy = true;
+		s->Callback = callback;
+		s->UserP = userp;
+
+		// The RX channel gets the lower number, so it's served first on the shared trigger
+		rx_ch = DMA_Allocate(SPI_DMADone, s);
+
+		if (rx_ch >= 0 && Size > 1) {
+			tx_ch = DMA_Allocate(NULL, NULL);
+
+			if (tx_ch < 0) {
+				DMA_Free(rx_ch);
+				rx_ch = -1;
+			}
 		}
+	}
 
-		// Reimu 20210525:
-		// Sometimes the RX FIFO will overflow (looks like a timing issue, TX 1 byte and RX 0 byte, SPI mode?), and the last while
-		// loop in this function will stuck forever because the missing bytes will make `dataReceivedCount' never be able to equal `Size'.
-		// So we changed the `if' to `while' to drain the RX FIFO as much as we can.
-		// We're glad that we figured this out without asking MCHP's “Warm” support team for help.
-		// Someone noticed this behavior as well, but it remained a mystery for them.
-		// https://electronics.stackexchange.com/questions/296086/pic24f-mplab-x-mcc-microchip-code-configurator-spi-driver-issue
-		// Don't make your code quality the same as Windows 10, dear MCHP.
-		while (hspi->STAT->SRXMPT == 0) {
-			*pReceived = *hspi->BUF;
+	if (rx_ch < 0) {
+		if (s) {
+			s->busy = false;
+		}
 
-			pReceived += receiveAddressIncrement;
-			dataReceivedCount++;
+		SPI_TransmitReceive(hspi, (uint8_t *)pTxData, pRxData, Size);
+
+		if (callback) {
+			callback(userp);
 		}
 
+		return true;
 	}
 
-	while (dataReceivedCount < Size) {
-		if (hspi->STAT->SRXMPT == 0) {
+	s->rx_ch = rx_ch;
+	s->tx_ch = tx_ch;
 
-			*pReceived = *hspi->BUF;
+	// Leftovers would fire the trigger before the first byte is out
+	while (hspi->STAT->SRXMPT == 0) {
+		PICo24_Discard16 = *hspi->BUF;
+	}
 
-			pReceived += receiveAddressIncrement;
-			dataReceivedCount++;
-		}
+	hspi->STAT->SPIROV = 0;
+
+	// An event per received byte. Only one is ever in flight, so none can hide behind another
+	s->sisel = hspi->STAT->SISEL;
+	hspi->STAT->SISEL = 1;
+
+	DMA_Setup(rx_ch, DMA_BYTE | (pRxData ? DMA_DST_INC : 0), hspi->DMA_TRIGGER, hspi->BUF, pRxData ? pRxData : &s->sink, Size);
+	DMA_Enable(rx_ch);
+
+	if (tx_ch >= 0) {
+		DMA_Setup(tx_ch, DMA_BYTE | (pTxData ? DMA_SRC_INC : 0), hspi->DMA_TRIGGER, pTxData ? pTxData + 1 : &s->fill, hspi->BUF, Size - 1);
+		DMA_Enable(tx_ch);
 	}
 
-	return dataSentCount;
+	// The first byte goes by hand, every one received sends the next
+	*hspi->BUF = pTxData ? pTxData[0] : s->fill;
+
+	return true;
+}
+
+bool SPI_Transmit_DMA(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint16_t Size, void (*callback)(void *userp), void *userp) {
+	return SPI_TransmitReceive_DMA(hspi, pTxData, NULL, Size, callback, userp);
 }
 
+bool SPI_Receive_DMA(const SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size, void (*callback)(void *userp), void *userp) {
+	return SPI_TransmitReceive_DMA(hspi, NULL, pRxData, Size, callback, userp);
+}
 
-uint16_t SPI_Transmit_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pTxData, uint16_t Size) {
-	// A trimmed version to make TX only operations faster.
+bool SPI_BusyDMA(const SPI_HandleTypeDef *hspi) {
+	SPI_DMAState *s = SPI_GetDMAState(hspi);
 
-	uint16_t dataSentCount = 0;
-	uint16_t dataReceivedCount = 0;
+	return s && s->busy;
+}
 
-	while (dataSentCount < Size) {
-		if (hspi->STAT->SPIBEC != 7) {
-			*hspi->BUF = *pTxData;
-			pTxData += 1;
-			dataSentCount++;
-		}
+void SPI_WaitDMA(const SPI_HandleTypeDef *hspi) {
+	SPI_DMAState *s = SPI_GetDMAState(hspi);
+
+	if (!s) {
+		return;
+	}
 
-		while (hspi->STAT->SRXMPT == 0) {
-			PICo24_Discard16 = *hspi->BUF;
-			dataReceivedCount++;
+#ifdef PICo24_FreeRTOS_Enabled
+	if (freertos_started) {
+		s->waiter = xTaskGetCurrentTaskHandle();
+
+		while (s->busy) {
+			ulTaskNotifyTake(pdTRUE, 1);
 		}
+
+		s->waiter = NULL;
+		return;
+	}
+#endif
+
+	while (s->busy) {
 	}
+}
+#endif
+
+#ifdef __HAS_EDS__
+static uint16_t SPI_Burst_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pTxData, auto_eds uint8_t *pRxData, uint16_t Size, uint8_t fill) {
+	volatile SPISTATBITS *stat = hspi->STAT;
+	volatile uint16_t *buf = hspi->BUF;
+	uint16_t dataSentCount = 0;
+	uint16_t dataReceivedCount = 0;
+
+	SPI_Flush(hspi);
 
 	while (dataReceivedCount < Size) {
-		if (hspi->STAT->SRXMPT == 0) {
-			PICo24_Discard16 = *hspi->BUF;
-			dataReceivedCount++;
+		uint16_t n = SPI_FIFO_DEPTH - (dataSentCount - dataReceivedCount);
+
+		if (n > Size - dataSentCount)
+			n = Size - dataSentCount;
+
+		dataSentCount += n;
+
+		if (pTxData) {
+			for (; n; n--)
+				*buf = *pTxData++;
+		} else {
+			for (; n; n--)
+				*buf = fill;
+		}
+
+		if (pRxData) {
+			while (stat->SRXMPT == 0) {
+				*pRxData++ = *buf;
+				dataReceivedCount++;
+			}
+		} else {
+			while (stat->SRXMPT == 0) {
+				PICo24_Discard16 = *buf;
+				dataReceivedCount++;
+			}
 		}
 	}
 
 	return dataSentCount;
 }
 
+uint16_t SPI_TransmitReceive_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pTxData, auto_eds uint8_t *pRxData, uint16_t Size) {
+	return SPI_Burst_EDS(hspi, pTxData, pRxData, Size, 0);
+}
+
+uint16_t SPI_Transmit_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pTxData, uint16_t Size) {
+	return SPI_Burst_EDS(hspi, pTxData, NULL, Size, 0);
+}
+
 uint16_t SPI_Receive_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pRxData, uint16_t Size) {
-	return SPI_TransmitReceive_EDS(hspi, NULL, pRxData, Size);
+	return SPI_Burst_EDS(hspi, NULL, pRxData, Size, 0);
+}
+
+uint16_t SPI_ReceiveFill_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pRxData, uint16_t Size, uint8_t fill) {
+	return SPI_Burst_EDS(hspi, NULL, pRxData, Size, fill);
 }
 
 #endif
@@ -21,6 +21,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <PICo24/Core/Core.h>
 
 
@@ -90,6 +91,7 @@ typedef struct {
 	volatile SPICON1BITS *CON1;
 	volatile SPICON1BITS *CON2;
 	volatile uint16_t *BUF;
+	uint8_t DMA_TRIGGER;	// SPIx event IRQ number, 0 to never use DMA
 } SPI_HandleTypeDef;
 
 enum {
@@ -142,9 +144,41 @@ extern void SPI_Disable(const SPI_HandleTypeDef *hspi);
 extern uint16_t SPI_TransmitReceive(const SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
 extern uint16_t SPI_Transmit(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint16_t Size);
 extern uint16_t SPI_Receive(const SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size);
+// Receives while sending `fill' instead of 0, e.g. 0xff for SD cards
+extern uint16_t SPI_ReceiveFill(const SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size, uint8_t fill);
+// Sends `pattern' Size times, anything received is dropped
+extern uint16_t SPI_Fill(const SPI_HandleTypeDef *hspi, uint8_t pattern, uint16_t Size);
+
+/*
+ * Word transfers for ports initialized with SPI_16BIT, Count in words.
+ * Eight words are in flight instead of eight bytes, so half the FIFO work per byte.
+ */
+extern uint16_t SPI_TransmitReceive16(const SPI_HandleTypeDef *hspi, const uint16_t *pTxData, uint16_t *pRxData, uint16_t Count);
+extern uint16_t SPI_Transmit16(const SPI_HandleTypeDef *hspi, const uint16_t *pTxData, uint16_t Count);
+extern uint16_t SPI_Receive16(const SPI_HandleTypeDef *hspi, uint16_t *pRxData, uint16_t Count);
+extern uint16_t SPI_Fill16(const SPI_HandleTypeDef *hspi, uint16_t pattern, uint16_t Count);
+// A byte stream over a SPI_16BIT port, two bytes per word with the wire order kept. Odd sizes, or 8 bit ports, go byte by byte
+extern uint16_t SPI_TransmitReceiveWords(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
+
+#ifdef PICo24_Enable_Peripheral_DMA
+/*
+ * Asynchronous transfers, one byte in flight moved by two DMA channels, so
+ * the CPU is free while the bus runs. The callback comes from the DMA
+ * interrupt when the last byte is in. Without DMA, or with no free channels,
+ * it falls back to SPI_TransmitReceive() and calls back before returning.
+ * Buffers must be in near RAM. Returns false if one is already running.
+ */
+extern bool SPI_TransmitReceive_DMA(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint8_t *pRxData, uint16_t Size, void (*callback)(void *userp), void *userp);
+extern bool SPI_Transmit_DMA(const SPI_HandleTypeDef *hspi, const uint8_t *pTxData, uint16_t Size, void (*callback)(void *userp), void *userp);
+extern bool SPI_Receive_DMA(const SPI_HandleTypeDef *hspi, uint8_t *pRxData, uint16_t Size, void (*callback)(void *userp), void *userp);
+extern bool SPI_BusyDMA(const SPI_HandleTypeDef *hspi);
+// Blocks until the running transfer, if any, is done
+extern void SPI_WaitDMA(const SPI_HandleTypeDef *hspi);
+#endif
 
 #ifdef __HAS_EDS__
 extern uint16_t SPI_TransmitReceive_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pTxData, auto_eds uint8_t *pRxData, uint16_t Size);
 extern uint16_t SPI_Transmit_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pTxData, uint16_t Size);
 extern uint16_t SPI_Receive_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pRxData, uint16_t Size);
+extern uint16_t SPI_ReceiveFill_EDS(const SPI_HandleTypeDef *hspi, auto_eds uint8_t *pRxData, uint16_t Size, uint8_t fill);
 #endif
\ No newline at end of file
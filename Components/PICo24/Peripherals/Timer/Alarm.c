@@ -0,0 +1,236 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Alarm.h"
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+
+#include <xc.h>
+
+#include <PICo24/Core/Delay.h>
+#include <PICo24/Core/Timebase.h>
+#include <PICo24/Core/Deferred.h>
+
+// Deadlines closer than this are treated as this far away
+#define ALARM_MIN_PERIOD	32
+
+static Alarm *alarm_heap[PICo24_Alarm_MaxPending];
+static uint8_t alarm_count;
+
+static inline bool Alarm_Before(uint32_t a, uint32_t b) {
+	return (int32_t)(a - b) < 0;
+}
+
+static inline void Alarm_Place(Alarm *alarm, uint8_t pos) {
+	alarm_heap[pos] = alarm;
+	alarm->index = pos + 1;
+}
+
+static void Alarm_SiftUp(uint8_t pos) {
+	Alarm *alarm = alarm_heap[pos];
+
+	while (pos) {
+		uint8_t parent = (pos - 1) / 2;
+
+		if (!Alarm_Before(alarm->deadline, alarm_heap[parent]->deadline)) {
+			break;
+		}
+
+		Alarm_Place(alarm_heap[parent], pos);
+		pos = parent;
+	}
+
+	Alarm_Place(alarm, pos);
+}
+
+static void Alarm_SiftDown(uint8_t pos) {
+	Alarm *alarm = alarm_heap[pos];
+
+	while (1) {
+		uint8_t child = pos * 2 + 1;
+
+		if (child >= alarm_count) {
+			break;
+		}
+
+		if (child + 1 < alarm_count && Alarm_Before(alarm_heap[child + 1]->deadline, alarm_heap[child]->deadline)) {
+			child++;
+		}
+
+		if (!Alarm_Before(alarm_heap[child]->deadline, alarm->deadline)) {
+			break;
+		}
+
+		Alarm_Place(alarm_heap[child], pos);
+		pos = child;
+	}
+
+	Alarm_Place(alarm, pos);
+}
+
+// An alarm whose deadline changed, up or down
+static void Alarm_Fix(uint8_t pos) {
+	if (pos && Alarm_Before(alarm_heap[pos]->deadline, alarm_heap[(pos - 1) / 2]->deadline)) {
+		Alarm_SiftUp(pos);
+	} else {
+		Alarm_SiftDown(pos);
+	}
+}
+
+static void Alarm_Remove(Alarm *alarm) {
+	uint8_t pos = alarm->index - 1;
+	Alarm *last = alarm_heap[--alarm_count];
+
+	alarm->index = 0;
+
+	if (last != alarm) {
+		alarm_heap[pos] = last;
+		Alarm_Fix(pos);
+	}
+}
+
+// Match at the earliest deadline, or just idle with the longest period if there is none.
+// The timer only wakes us up, the time itself comes from the timebase
+static void Alarm_Program(uint32_t now) {
+	Timer_HandleTypeDef *htimer = &PICo24_Alarm_Timer;
+	uint32_t period = 0xffffffff;
+
+	if (alarm_count) {
+		int32_t d = alarm_heap[0]->deadline - now;
+
+		period = (d < ALARM_MIN_PERIOD ? ALARM_MIN_PERIOD : d) - 1;
+	}
+
+	Timer_Stop(htimer);
+	Timer_SetPeriod(htimer, period);
+	Timer_ClearInterrupt(htimer->UPPER);
+	Timer_SetValue(htimer, 0);
+}
+
+static void Alarm_Fire(Alarm *alarm) {
+#ifdef PICo24_FreeRTOS_Enabled
+	if (alarm->flags & ALARM_DEFERRED) {
+		Deferred_Post(DEFERRED_HIGH, alarm->Callback, alarm->UserP);
+		return;
+	}
+#endif
+
+	alarm->Callback(alarm->UserP);
+}
+
+static void Alarm_Interrupt(void *userp) {
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	while (alarm_count && !Alarm_Before(PICo24_CycleStamp(), alarm_heap[0]->deadline)) {
+		Alarm *alarm = alarm_heap[0];
+
+		Alarm_Remove(alarm);
+
+		RESTORE_CPU_IPL(ipl);
+		Alarm_Fire(alarm);
+		SET_AND_SAVE_CPU_IPL(ipl, 7);
+	}
+
+	Alarm_Program(PICo24_CycleStamp());
+
+	RESTORE_CPU_IPL(ipl);
+}
+
+void Alarm_Initialize() {
+	Timer_HandleTypeDef *htimer = &PICo24_Alarm_Timer;
+
+	Timer_Initialize(htimer, TIMER_32BIT);
+	Timer_SetSpeedByPrescaler(htimer, TIMER_PS_1_1);
+
+	alarm_count = 0;
+
+	// In 32-bit mode the interrupt comes from the upper timer
+	Timer_SetInterruptHandler(htimer->UPPER, Alarm_Interrupt, NULL);
+	Timer_SetInterrupt(htimer->UPPER, true);
+
+	// Also starts it
+	Alarm_Program(PICo24_CycleStamp());
+}
+
+void Alarm_Init(Alarm *alarm, void (*callback)(void *), void *userp, uint8_t flags) {
+	alarm->deadline = 0;
+	alarm->Callback = callback;
+	alarm->UserP = userp;
+	alarm->flags = flags;
+	alarm->index = 0;
+}
+
+bool Alarm_StartAt(Alarm *alarm, uint32_t deadline) {
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	alarm->deadline = deadline;
+
+	if (alarm->index) {
+		Alarm_Fix(alarm->index - 1);
+	} else {
+		if (alarm_count == PICo24_Alarm_MaxPending) {
+			RESTORE_CPU_IPL(ipl);
+			return false;
+		}
+
+		alarm_heap[alarm_count] = alarm;
+		alarm_count++;
+		Alarm_SiftUp(alarm_count - 1);
+	}
+
+	// Only when it's the new earliest. If it just moved later, the timer fires early and reprograms itself
+	if (alarm_heap[0] == alarm) {
+		Alarm_Program(PICo24_CycleStamp());
+	}
+
+	RESTORE_CPU_IPL(ipl);
+
+	return true;
+}
+
+bool Alarm_Start(Alarm *alarm, uint32_t delay_us) {
+	return Alarm_StartAt(alarm, PICo24_CycleStamp() + Alarm_MicrosecondsToCycles(delay_us));
+}
+
+// The timer isn't touched, an interrupt for a cancelled alarm just reprograms it
+bool Alarm_Cancel(Alarm *alarm) {
+	uint16_t ipl;
+	bool ret = false;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+
+	if (alarm->index) {
+		Alarm_Remove(alarm);
+		ret = true;
+	}
+
+	RESTORE_CPU_IPL(ipl);
+
+	return ret;
+}
+
+uint32_t Alarm_MicrosecondsToCycles(uint32_t us) {
+	return us * FCY_DIV_1000000;
+}
+
+#endif
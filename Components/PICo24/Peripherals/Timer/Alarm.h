@@ -0,0 +1,79 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+
+#include "Timer.h"
+
+/*
+ * One-shot alarms with cycle resolution, all sharing one 32-bit timer pair.
+ * Pending alarms sit in a min-heap ordered by deadline, and the timer period
+ * is reprogrammed to the earliest one, so starting, cancelling and moving an
+ * alarm are O(log n). Timer 2/3 by default, define PICo24_Alarm_Timer to use
+ * another pair.
+ *
+ * Deadlines are PICo24_CycleStamp() values, so the Timebase must be
+ * initialized first, and can be at most 2^31 cycles (~134s) away.
+ *
+ * Callbacks run in the timer ISR, or with ALARM_DEFERRED from the high level
+ * deferred worker. They may start the alarm again.
+ */
+
+#ifndef PICo24_Alarm_Timer
+#define PICo24_Alarm_Timer		htimer2
+#endif
+
+#ifndef PICo24_Alarm_MaxPending
+#define PICo24_Alarm_MaxPending		16
+#endif
+
+enum {
+	ALARM_ISR = 0x0,
+	ALARM_DEFERRED = 0x1,
+};
+
+typedef struct {
+	uint32_t deadline;
+	void (*Callback)(void *userp);
+	void *UserP;
+	uint8_t flags;
+	uint8_t index;		// Position in the heap + 1, 0 if not pending
+} Alarm;
+
+extern void Alarm_Initialize();
+
+extern void Alarm_Init(Alarm *alarm, void (*callback)(void *), void *userp, uint8_t flags);
+
+// Also reschedule if already pending. Returns false if too many are pending
+extern bool Alarm_StartAt(Alarm *alarm, uint32_t deadline);
+extern bool Alarm_Start(Alarm *alarm, uint32_t delay_us);
+extern bool Alarm_Cancel(Alarm *alarm);
+
+extern uint32_t Alarm_MicrosecondsToCycles(uint32_t us);
+
+static inline bool Alarm_Pending(const Alarm *alarm) {
+	return alarm->index != 0;
+}
+
+#endif
\ No newline at end of file
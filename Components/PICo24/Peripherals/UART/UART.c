@@ -19,11 +19,209 @@
 
 #include "UART.h"
 
+#include <xc.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <PICo24/Core/Delay.h>
 #include <PICo24/Core/FreeRTOS_Support.h>
+#include <PICo24/Library/RingBuffer.h>
+
+#ifdef PICo24_FreeRTOS_Enabled
+#include <FreeRTOS/semphr.h>
+#endif
+
+#ifdef PICo24_Enable_Peripheral_DMA
+#include <PICo24/Peripherals/DMA/DMA.h>
+#endif
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+#include <PICo24/Core/Timebase.h>
+#include <PICo24/Peripherals/Timer/Alarm.h>
+#endif
 
 #ifdef PICo24_Enable_Peripheral_UART
 
+#define UART_IRQ_RX		0x1
+#define UART_IRQ_TX		0x2
+#define UART_IRQ_ERR		0x4
+
+typedef struct {
+	RingBuffer rx;
+	RingBuffer tx;
+	UART_Stats stats;
+	uint32_t read_timeout_ms;
+#ifdef PICo24_FreeRTOS_Enabled
+	SemaphoreHandle_t tx_lock;
+#endif
+	uint8_t index;
+	bool buffered;
+
+	// The open frame, only touched by the RX interrupt
+	UART_Frame cur;
+
+	// RTS, see UART_SetFlowControl()
+	volatile uint16_t *rts_lat;
+	uint16_t rts_mask;
+	uint16_t rts_high;
+	uint16_t rts_low;
+	volatile bool throttled;
+
+	// DMA channels + 1, 0 when the interrupts move the data
+	const UART_HandleTypeDef *huart;
+	uint8_t rx_dma;
+	uint8_t tx_dma;
+	uint16_t tx_dma_len;	// Span being sent, 0 if idle
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+	// Bytes of a frame stay in the RX ring, these only mark where each one ends
+	UART_Frame *frames;
+	volatile uint8_t frame_head;
+	volatile uint8_t frame_tail;
+
+	uint16_t cur_head;	// RX ring head when the open frame started
+	uint32_t gap;		// In cycles
+	Alarm gap_alarm;
+#ifdef PICo24_FreeRTOS_Enabled
+	volatile TaskHandle_t frame_task;
+#endif
+#endif
+} UART_Port;
+
+static UART_Port uart_ports[4];
+
+// The handles are const and board defined, so tell the UARTs apart by their registers
+static UART_Port *UART_GetPort(const UART_HandleTypeDef *huart) {
+	uint8_t i;
+
+	if (huart->STA == (volatile UARTSTABITS *)&U1STA) {
+		i = 0;
+	} else if (huart->STA == (volatile UARTSTABITS *)&U2STA) {
+		i = 1;
+#ifdef _U3RXIE
+	} else if (huart->STA == (volatile UARTSTABITS *)&U3STA) {
+		i = 2;
+#endif
+#ifdef _U4RXIE
+	} else if (huart->STA == (volatile UARTSTABITS *)&U4STA) {
+		i = 3;
+#endif
+	} else {
+		return NULL;
+	}
+
+	uart_ports[i].index = i;
+
+	return &uart_ports[i];
+}
+
+// The interrupt bits are all over the place, let the device header sort them out
+static void UART_SetIRQ(uint8_t index, uint8_t irqs, bool enabled) {
+	switch (index) {
+		case 0:
+			if (irqs & UART_IRQ_RX) _U1RXIE = enabled;
+			if (irqs & UART_IRQ_TX) _U1TXIE = enabled;
+			if (irqs & UART_IRQ_ERR) _U1ERIE = enabled;
+			break;
+		case 1:
+			if (irqs & UART_IRQ_RX) _U2RXIE = enabled;
+			if (irqs & UART_IRQ_TX) _U2TXIE = enabled;
+			if (irqs & UART_IRQ_ERR) _U2ERIE = enabled;
+			break;
+#ifdef _U3RXIE
+		case 2:
+			if (irqs & UART_IRQ_RX) _U3RXIE = enabled;
+			if (irqs & UART_IRQ_TX) _U3TXIE = enabled;
+			if (irqs & UART_IRQ_ERR) _U3ERIE = enabled;
+			break;
+#endif
+#ifdef _U4RXIE
+		case 3:
+			if (irqs & UART_IRQ_RX) _U4RXIE = enabled;
+			if (irqs & UART_IRQ_TX) _U4TXIE = enabled;
+			if (irqs & UART_IRQ_ERR) _U4ERIE = enabled;
+			break;
+#endif
+		default:
+			break;
+	}
+}
+
+static void UART_SetIRQPriority(uint8_t index, uint8_t ipl) {
+	switch (index) {
+		case 0:
+			_U1RXIP = _U1TXIP = _U1ERIP = ipl;
+			break;
+		case 1:
+			_U2RXIP = _U2TXIP = _U2ERIP = ipl;
+			break;
+#ifdef _U3RXIE
+		case 2:
+			_U3RXIP = _U3TXIP = _U3ERIP = ipl;
+			break;
+#endif
+#ifdef _U4RXIE
+		case 3:
+			_U4RXIP = _U4TXIP = _U4ERIP = ipl;
+			break;
+#endif
+		default:
+			break;
+	}
+}
+
+// Setting the flag by hand runs the TX interrupt, which fills the FIFO
+static void UART_KickTx(uint8_t index) {
+	switch (index) {
+		case 0:
+			_U1TXIE = 1;
+			_U1TXIF = 1;
+			break;
+		case 1:
+			_U2TXIE = 1;
+			_U2TXIF = 1;
+			break;
+#ifdef _U3RXIE
+		case 2:
+			_U3TXIE = 1;
+			_U3TXIF = 1;
+			break;
+#endif
+#ifdef _U4RXIE
+		case 3:
+			_U4TXIE = 1;
+			_U4TXIF = 1;
+			break;
+#endif
+		default:
+			break;
+	}
+}
+
+// Same trick for the RX interrupt, to pick up what piled up in the FIFO or check the frame gap
+static void UART_KickRx(uint8_t index) {
+	switch (index) {
+		case 0:
+			_U1RXIF = 1;
+			break;
+		case 1:
+			_U2RXIF = 1;
+			break;
+#ifdef _U3RXIE
+		case 2:
+			_U3RXIF = 1;
+			break;
+#endif
+#ifdef _U4RXIE
+		case 3:
+			_U4RXIF = 1;
+			break;
+#endif
+		default:
+			break;
+	}
+}
+
 void UART_Initialize(const UART_HandleTypeDef *huart, uint16_t uart_mode, uint16_t speed) {
 	volatile UARTMODEBITS *m = huart->MODE;
 
@@ -55,9 +253,10 @@ void UART_Initialize(const UART_HandleTypeDef *huart, uint16_t uart_mode, uint16
 	m->LPBACK = 0;
 	m->WAKE = 0;
 
+	// RTSMD set would be simplex mode, where RTS only means we're transmitting
 	if (uart_mode & UART_CRTSCTS) {
 		m->UEN = 2;
-		m->RTSMD = 1;
+		m->RTSMD = 0;
 	} else {
 		m->UEN = 0;
 		m->RTSMD = 0;
@@ -112,4 +311,775 @@ uint16_t UART_Receive(const UART_HandleTypeDef *huart, uint8_t *buf, uint16_t le
 	return len;
 }
 
+bool UART_StartBuffered(const UART_HandleTypeDef *huart, uint16_t rx_size, uint16_t tx_size) {
+	UART_Port *p = UART_GetPort(huart);
+
+	if (!p) {
+		return false;
+	}
+
+	if (p->buffered) {
+		return true;
+	}
+
+	uint8_t *rx_buf = malloc(rx_size);
+	uint8_t *tx_buf = malloc(tx_size);
+
+	if (!rx_buf || !tx_buf || !RingBuffer_Init(&p->rx, rx_buf, rx_size) || !RingBuffer_Init(&p->tx, tx_buf, tx_size)) {
+		free(rx_buf);
+		free(tx_buf);
+		return false;
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	p->tx_lock = xSemaphoreCreateMutex();
+
+	if (!p->tx_lock) {
+		free(rx_buf);
+		free(tx_buf);
+		return false;
+	}
+
+	UART_SetIRQPriority(p->index, configKERNEL_INTERRUPT_PRIORITY);
+#endif
+
+	memset(&p->stats, 0, sizeof(p->stats));
+
+	// RX interrupt on every character, TX interrupt when the last one in the FIFO moves to the shift register
+	huart->STA->URXISEL = 0;
+	huart->STA->UTXISEL1 = 1;
+	huart->STA->UTXISEL0 = 0;
+
+	// Whatever arrived while polling is stale
+	while (huart->STA->URXDA) {
+		(void)*huart->RXREG;
+	}
+
+	huart->STA->OERR = 0;
+
+	p->buffered = true;
+
+	UART_SetIRQ(p->index, UART_IRQ_TX, false);
+	UART_SetIRQ(p->index, UART_IRQ_RX | UART_IRQ_ERR, true);
+
+	return true;
+}
+
+bool UART_IsBuffered(const UART_HandleTypeDef *huart) {
+	UART_Port *p = UART_GetPort(huart);
+
+	return p && p->buffered;
+}
+
+void UART_SetReadTimeout(const UART_HandleTypeDef *huart, uint32_t timeout_ms) {
+	UART_Port *p = UART_GetPort(huart);
+
+	if (p) {
+		p->read_timeout_ms = timeout_ms;
+	}
+}
+
+bool UART_SetFlowControl(const UART_HandleTypeDef *huart, volatile uint16_t *rts_lat, uint16_t rts_mask, uint16_t high, uint16_t low) {
+	UART_Port *p = UART_GetPort(huart);
+	uint16_t ipl;
+
+	if (!p || !p->buffered || p->rx_dma || huart->MODE->UEN != 2) {
+		return false;
+	}
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+	// The frame gap is checked in the RX interrupt, which the hardware RTS way switches off
+	if (!rts_lat && p->frames) {
+		return false;
+	}
+#endif
+
+	uint16_t size = RingBuffer_Size(&p->rx);
+
+	if (!high) {
+		high = size / 4 * 3;
+	}
+
+	if (!low) {
+		low = size / 4;
+	}
+
+	if (high > size || low >= high) {
+		return false;
+	}
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	p->rts_lat = rts_lat;
+	p->rts_mask = rts_mask;
+	p->rts_high = high;
+	p->rts_low = low;
+	p->throttled = false;
+
+	if (rts_lat) {
+		*rts_lat &= ~rts_mask;
+	}
+	RESTORE_CPU_IPL(ipl);
+
+	return true;
+}
+
+// Called by the RX interrupt after filling the ring
+static void UART_Throttle(UART_Port *p) {
+	if (p->throttled || !p->rts_high || RingBuffer_Used(&p->rx) < p->rts_high) {
+		return;
+	}
+
+	if (p->rts_lat) {
+		*p->rts_lat |= p->rts_mask;
+	} else {
+		UART_SetIRQ(p->index, UART_IRQ_RX | UART_IRQ_ERR, false);
+	}
+
+	p->throttled = true;
+	p->stats.throttled++;
+}
+
+// Called by readers after taking bytes out
+static void UART_Unthrottle(UART_Port *p) {
+	uint16_t ipl;
+
+	if (!p->throttled || RingBuffer_Used(&p->rx) > p->rts_low) {
+		return;
+	}
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	if (p->throttled) {
+		p->throttled = false;
+
+		if (p->rts_lat) {
+			*p->rts_lat &= ~p->rts_mask;
+		} else {
+			UART_SetIRQ(p->index, UART_IRQ_RX | UART_IRQ_ERR, true);
+			UART_KickRx(p->index);
+		}
+	}
+	RESTORE_CPU_IPL(ipl);
+}
+
+static void UART_YieldFromISR(bool woken) {
+#ifdef PICo24_FreeRTOS_Enabled
+	if (woken && freertos_started) {
+		taskYIELD();
+	}
+#endif
+}
+
+// Until the TX side has taken everything out of the ring
+static void UART_WaitTxRingEmpty(UART_Port *p) {
+#ifdef PICo24_FreeRTOS_Enabled
+	if (freertos_started) {
+		RingBuffer_WaitWritable(&p->tx, RingBuffer_Size(&p->tx), portMAX_DELAY);
+		return;
+	}
+#endif
+
+	while (!RingBuffer_Empty(&p->tx)) {
+	}
+}
+
+#ifdef PICo24_Enable_Peripheral_DMA
+// Brings the RX ring head up to where the DMA is writing. Only the reader fixes up an overrun, it owns the tail
+static void UART_SyncRxDMA(UART_Port *p, bool reader) {
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	uint16_t pos = DMA_CurrentDestination(p->rx_dma - 1) - (uint16_t)p->rx.buf;
+	uint16_t head = p->rx.head;
+
+	head += (uint16_t)(pos - head) & p->rx.mask;
+	p->rx.head = head;
+
+	if (reader && RingBuffer_Used(&p->rx) > RingBuffer_Size(&p->rx)) {
+		p->stats.rx_dropped += RingBuffer_Used(&p->rx) - RingBuffer_Size(&p->rx);
+		p->rx.tail = head - RingBuffer_Size(&p->rx);
+	}
+	RESTORE_CPU_IPL(ipl);
+}
+
+static void UART_RxDMAEvent(void *userp, uint8_t events) {
+	UART_Port *p = userp;
+
+	UART_SyncRxDMA(p, false);
+
+#ifdef PICo24_FreeRTOS_Enabled
+	BaseType_t woken = pdFALSE;
+
+	RingBuffer_NotifyRxFromISR(&p->rx, &woken);
+	UART_YieldFromISR(woken);
+#endif
+}
+
+static void UART_StartTxDMA(UART_Port *p) {
+	uint8_t *span;
+	uint16_t n;
+	uint16_t ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	if (!p->tx_dma_len && (n = RingBuffer_PeekRead(&p->tx, &span))) {
+		int8_t ch = p->tx_dma - 1;
+
+		p->tx_dma_len = n;
+		DMA_Setup(ch, DMA_BYTE | DMA_SRC_INC, p->huart->DMA_TX_TRIGGER, span, p->huart->TXREG, n);
+		DMA_Enable(ch);
+
+		// The trigger only comes when a character leaves the FIFO, so start by hand if it has room
+		if (!p->huart->STA->UTXBF) {
+			DMA_Request(ch);
+		}
+	}
+	RESTORE_CPU_IPL(ipl);
+}
+
+static void UART_TxDMAEvent(void *userp, uint8_t events) {
+	UART_Port *p = userp;
+	uint16_t n = p->tx_dma_len;
+
+	if (!(events & DMA_EVENT_DONE)) {
+		return;
+	}
+
+	p->tx_dma_len = 0;
+	p->stats.tx_bytes += n;
+
+#ifdef PICo24_FreeRTOS_Enabled
+	BaseType_t woken = pdFALSE;
+
+	RingBuffer_CommitReadFromISR(&p->tx, n, &woken);
+#else
+	RingBuffer_CommitRead(&p->tx, n);
+#endif
+
+	UART_StartTxDMA(p);
+
+#ifdef PICo24_FreeRTOS_Enabled
+	UART_YieldFromISR(woken);
+#endif
+}
+
+bool UART_StartDMA(const UART_HandleTypeDef *huart, uint16_t rx_size, uint16_t tx_size) {
+	UART_Port *p = UART_GetPort(huart);
+	uint16_t ipl;
+
+	if (!UART_StartBuffered(huart, rx_size, tx_size)) {
+		return false;
+	}
+
+	p->huart = huart;
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+	bool framed = p->frames != NULL;
+#else
+	bool framed = false;
+#endif
+
+	if (!p->rx_dma && !framed && !p->rts_high && huart->DMA_RX_TRIGGER) {
+		int8_t ch = DMA_Allocate(UART_RxDMAEvent, p);
+
+		if (ch >= 0) {
+			SET_AND_SAVE_CPU_IPL(ipl, 7);
+			UART_SetIRQ(p->index, UART_IRQ_RX, false);
+			RingBuffer_Reset(&p->rx);
+
+			// What's already in the FIFO would never trigger the channel, and is as stale as in UART_StartBuffered()
+			while (huart->STA->URXDA) {
+				(void)*huart->RXREG;
+			}
+
+			// Wraps around the whole ring for good, and reports every half of it
+			DMA_Setup(ch, DMA_BYTE | DMA_DST_INC | DMA_REPEAT | DMA_HALF, huart->DMA_RX_TRIGGER, huart->RXREG, p->rx.buf, RingBuffer_Size(&p->rx));
+			DMA_Enable(ch);
+			p->rx_dma = ch + 1;
+			RESTORE_CPU_IPL(ipl);
+		}
+	}
+
+	if (!p->tx_dma && huart->DMA_TX_TRIGGER) {
+		int8_t ch = DMA_Allocate(UART_TxDMAEvent, p);
+
+		if (ch >= 0) {
+			// Wait for the interrupts to finish what they have
+			UART_WaitTxRingEmpty(p);
+
+			SET_AND_SAVE_CPU_IPL(ipl, 7);
+			UART_SetIRQ(p->index, UART_IRQ_TX, false);
+
+			// A trigger for every character that moves to the shift register
+			huart->STA->UTXISEL1 = 0;
+			huart->STA->UTXISEL0 = 0;
+
+			p->tx_dma_len = 0;
+			p->tx_dma = ch + 1;
+			RESTORE_CPU_IPL(ipl);
+		}
+	}
+
+	return true;
+}
+#endif
+
+static bool UART_RxEmpty(UART_Port *p) {
+#ifdef PICo24_Enable_Peripheral_DMA
+	if (p->rx_dma) {
+		UART_SyncRxDMA(p, true);
+	}
+#endif
+
+	return RingBuffer_Empty(&p->rx);
+}
+
+static void UART_StartTx(UART_Port *p) {
+#ifdef PICo24_Enable_Peripheral_DMA
+	if (p->tx_dma) {
+		UART_StartTxDMA(p);
+		return;
+	}
+#endif
+
+	UART_KickTx(p->index);
+}
+
+uint16_t UART_Write(const UART_HandleTypeDef *huart, const uint8_t *buf, uint16_t len) {
+	UART_Port *p = UART_GetPort(huart);
+	uint16_t done = 0;
+
+	if (!p || !p->buffered) {
+		UART_Transmit(huart, buf, len);
+		return len;
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	// Several tasks may write, the ring only takes one producer
+	if (freertos_started) {
+		xSemaphoreTake(p->tx_lock, portMAX_DELAY);
+	}
+#endif
+
+	while (done < len) {
+		uint16_t n = RingBuffer_Write(&p->tx, buf + done, len - done);
+
+		if (n) {
+			done += n;
+			UART_StartTx(p);
+			continue;
+		}
+
+		p->stats.tx_blocked++;
+
+#ifdef PICo24_FreeRTOS_Enabled
+		if (freertos_started) {
+			uint16_t want = len - done;
+
+			// Don't wake up for every byte the ISR takes
+			if (want > RingBuffer_Size(&p->tx) / 2) {
+				want = RingBuffer_Size(&p->tx) / 2;
+			}
+
+			RingBuffer_WaitWritable(&p->tx, want, portMAX_DELAY);
+		}
+#endif
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (freertos_started) {
+		xSemaphoreGive(p->tx_lock);
+	}
+#endif
+
+	return done;
+}
+
+static uint16_t UART_ReadRing(UART_Port *p, uint8_t *buf, uint16_t len) {
+	uint16_t n = RingBuffer_Read(&p->rx, buf, len);
+
+	UART_Unthrottle(p);
+
+	return n;
+}
+
+uint16_t UART_Read(const UART_HandleTypeDef *huart, uint8_t *buf, uint16_t len) {
+	UART_Port *p = UART_GetPort(huart);
+
+	if (!p || !p->buffered) {
+		return UART_Receive(huart, buf, len);
+	}
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+	if (p->frames) {
+		return UART_ReadFrame(huart, buf, len, NULL);
+	}
+#endif
+
+	if (!len || !UART_RxEmpty(p)) {
+		return UART_ReadRing(p, buf, len);
+	}
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (freertos_started) {
+		TickType_t timeout = p->read_timeout_ms ? p->read_timeout_ms / portTICK_PERIOD_MS : portMAX_DELAY;
+
+		if (p->rx_dma) {
+			// The DMA only speaks up every half ring, so look every tick
+			for (TickType_t waited=0; UART_RxEmpty(p) && (timeout == portMAX_DELAY || waited < timeout); waited++) {
+				RingBuffer_WaitReadable(&p->rx, 1, 1);
+			}
+		} else {
+			RingBuffer_WaitReadable(&p->rx, 1, timeout ? timeout : 1);
+		}
+
+		return UART_ReadRing(p, buf, len);
+	}
+#endif
+
+	for (uint32_t waited=0; UART_RxEmpty(p); waited++) {
+		if (p->read_timeout_ms && waited >= p->read_timeout_ms) {
+			return 0;
+		}
+
+		Delay_Milliseconds(1);
+	}
+
+	return UART_ReadRing(p, buf, len);
+}
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+static void UART_GapElapsed(void *userp) {
+	UART_KickRx(((UART_Port *)userp)->index);
+}
+
+bool UART_StartFrames(const UART_HandleTypeDef *huart, uint16_t rx_size, uint16_t tx_size, uint16_t gap_tenths) {
+	UART_Port *p = UART_GetPort(huart);
+	volatile UARTMODEBITS *m = huart->MODE;
+
+	if (!p || p->frames || p->rx_dma) {
+		return p && p->frames;
+	}
+
+	UART_Frame *frames = malloc(sizeof(UART_Frame) * PICo24_UART_FrameQueue);
+
+	if (!frames) {
+		return false;
+	}
+
+	// Start bit, data, parity and stop bits, with BRGH set
+	uint32_t bits = 1 + (m->PDSEL == 3 ? 9 : 8) + (m->PDSEL == 1 || m->PDSEL == 2) + (m->STSEL ? 2 : 1);
+	uint32_t char_cycles = bits * 4 * ((uint32_t)*huart->BRG + 1);
+
+	p->gap = char_cycles * (gap_tenths ? gap_tenths : 35) / 10;
+	p->frame_head = p->frame_tail = 0;
+	memset(&p->cur, 0, sizeof(p->cur));
+	Alarm_Init(&p->gap_alarm, UART_GapElapsed, p, ALARM_ISR);
+
+	// The RX interrupt looks at frames as soon as it's enabled
+	p->frames = frames;
+
+	if (!UART_StartBuffered(huart, rx_size, tx_size)) {
+		p->frames = NULL;
+		free(frames);
+		return false;
+	}
+
+	return true;
+}
+
+void UART_SetFrameGap(const UART_HandleTypeDef *huart, uint32_t gap_us) {
+	UART_Port *p = UART_GetPort(huart);
+
+	if (p) {
+		p->gap = Alarm_MicrosecondsToCycles(gap_us);
+	}
+}
+
+static bool UART_WaitFrame(UART_Port *p) {
+#ifdef PICo24_FreeRTOS_Enabled
+	if (freertos_started) {
+		TickType_t timeout = p->read_timeout_ms ? p->read_timeout_ms / portTICK_PERIOD_MS : portMAX_DELAY;
+		TickType_t start = xTaskGetTickCount();
+
+		if (!timeout) {
+			timeout = 1;
+		}
+
+		while (p->frame_head == p->frame_tail) {
+			TickType_t waited = xTaskGetTickCount() - start;
+
+			if (waited >= timeout) {
+				return false;
+			}
+
+			// Registering before looking again, so a frame closed in between still wakes us up
+			p->frame_task = xTaskGetCurrentTaskHandle();
+
+			if (p->frame_head == p->frame_tail) {
+				ulTaskNotifyTake(pdTRUE, timeout == portMAX_DELAY ? portMAX_DELAY : timeout - waited);
+			}
+
+			p->frame_task = NULL;
+		}
+
+		return true;
+	}
+#endif
+
+	for (uint32_t waited=0; p->frame_head == p->frame_tail; waited++) {
+		if (p->read_timeout_ms && waited >= p->read_timeout_ms) {
+			return false;
+		}
+
+		Delay_Milliseconds(1);
+	}
+
+	return true;
+}
+
+uint16_t UART_ReadFrame(const UART_HandleTypeDef *huart, uint8_t *buf, uint16_t len, UART_Frame *info) {
+	UART_Port *p = UART_GetPort(huart);
+
+	if (!p || !p->frames || !UART_WaitFrame(p)) {
+		return 0;
+	}
+
+	UART_Frame f = p->frames[p->frame_tail & (PICo24_UART_FrameQueue - 1)];
+	uint16_t n = f.len < len ? f.len : len;
+
+	RingBuffer_Read(&p->rx, buf, n);
+
+	if (f.len > n) {
+		RingBuffer_CommitRead(&p->rx, f.len - n);
+		f.flags |= UART_FRAME_TRUNCATED;
+	}
+
+	p->frame_tail++;
+	UART_Unthrottle(p);
+
+	if (info) {
+		*info = f;
+	}
+
+	return n;
+}
+#endif
+
+void UART_Drain(const UART_HandleTypeDef *huart) {
+	UART_Port *p = UART_GetPort(huart);
+
+	if (p && p->buffered) {
+		UART_WaitTxRingEmpty(p);
+	}
+
+	// CTS may hold the last character for a while, so sleep rather than spin
+	while (!huart->STA->TRMT) {
+#ifdef PICo24_FreeRTOS_Enabled
+		if (freertos_started) {
+			vTaskDelay(1);
+		}
+#endif
+	}
+}
+
+bool UART_GetStats(const UART_HandleTypeDef *huart, UART_Stats *stats) {
+	UART_Port *p = UART_GetPort(huart);
+	uint16_t ipl;
+
+	if (!p) {
+		return false;
+	}
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);
+	*stats = p->stats;
+	RESTORE_CPU_IPL(ipl);
+
+	return true;
+}
+
+void UART_ResetStats(const UART_HandleTypeDef *huart) {
+	UART_Port *p = UART_GetPort(huart);
+	uint16_t ipl;
+
+	if (p) {
+		SET_AND_SAVE_CPU_IPL(ipl, 7);
+		memset(&p->stats, 0, sizeof(p->stats));
+		RESTORE_CPU_IPL(ipl);
+	}
+}
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+// Returns true if the frame was queued
+static bool UART_CloseFrame(UART_Port *p) {
+	UART_Frame *f = &p->cur;
+	bool queued = false;
+
+	if (!f->len && !f->flags) {
+		return false;
+	}
+
+	// Nobody reads the bytes of an open frame, so they can be taken back
+	if ((f->flags & UART_FRAME_OVERFLOW) || (uint8_t)(p->frame_head - p->frame_tail) >= PICo24_UART_FrameQueue) {
+		p->rx.head = p->cur_head;
+		p->stats.frames_dropped++;
+	} else {
+		p->frames[p->frame_head & (PICo24_UART_FrameQueue - 1)] = *f;
+		RingBuffer_Barrier();
+		p->frame_head++;
+		p->stats.frames++;
+		queued = true;
+	}
+
+	f->len = 0;
+	f->flags = 0;
+
+	return queued;
+}
+#endif
+
+void UART_ProcessRxInterrupt(const UART_HandleTypeDef *huart) {
+	UART_Port *p = UART_GetPort(huart);
+	uint16_t n = 0;
+
+	if (!p || !p->buffered) {
+		return;
+	}
+
+	// The DMA owns the FIFO, only the error interrupt gets here
+	if (p->rx_dma) {
+		if (huart->STA->OERR) {
+			huart->STA->OERR = 0;
+			p->stats.overrun++;
+		}
+
+		return;
+	}
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+	UART_Frame *f = &p->cur;
+	bool closed = false;
+	uint32_t now = 0;
+
+	if (p->frames) {
+		now = PICo24_CycleStamp();
+
+		// Interrupts come a character apart at most, so if the gap is already over, what's in the FIFO is a new frame
+		if ((f->len || f->flags) && now - f->end >= p->gap) {
+			closed = UART_CloseFrame(p);
+		}
+
+		if (!f->len && !f->flags) {
+			p->cur_head = p->rx.head;
+			f->start = now;
+		}
+	}
+#endif
+
+	while (huart->STA->URXDA) {
+		// Both describe the character at the top of the FIFO, so look before reading it
+		if (huart->STA->FERR) {
+			p->stats.framing++;
+			p->cur.flags |= UART_FRAME_ERROR;
+		}
+
+		if (huart->STA->PERR) {
+			p->stats.parity++;
+			p->cur.flags |= UART_FRAME_ERROR;
+		}
+
+		if (!RingBuffer_PutChar(&p->rx, *huart->RXREG)) {
+			p->stats.rx_dropped++;
+			p->cur.flags |= UART_FRAME_OVERFLOW;
+		}
+
+		n++;
+	}
+
+	p->stats.rx_bytes += n;
+
+	// Reception stops until it's cleared, which also empties the FIFO, so only after draining it
+	if (huart->STA->OERR) {
+		huart->STA->OERR = 0;
+		p->stats.overrun++;
+		p->cur.flags |= UART_FRAME_OVERFLOW;
+	}
+
+	UART_Throttle(p);
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+	if (p->frames) {
+		if (n) {
+			f->len = p->rx.head - p->cur_head;
+			f->end = now;
+		}
+
+		if (f->len || f->flags) {
+			if (!n && now - f->end >= p->gap) {
+				closed |= UART_CloseFrame(p);
+			} else if (!Alarm_Pending(&p->gap_alarm)) {
+				// Armed once per gap, an early expiry just lands here again
+				Alarm_StartAt(&p->gap_alarm, f->end + p->gap);
+			}
+		}
+
+		// A dropped frame may have made room
+		UART_Unthrottle(p);
+
+		// Readers wait for whole frames, not bytes
+		n = 0;
+	}
+#endif
+
+#ifdef PICo24_FreeRTOS_Enabled
+	BaseType_t woken = pdFALSE;
+
+	if (n) {
+		RingBuffer_NotifyRxFromISR(&p->rx, &woken);
+	}
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+	if (closed && p->frame_task) {
+		vTaskNotifyGiveFromISR(p->frame_task, &woken);
+	}
+#endif
+
+	UART_YieldFromISR(woken);
+#endif
+}
+
+void UART_ProcessTxInterrupt(const UART_HandleTypeDef *huart) {
+	UART_Port *p = UART_GetPort(huart);
+	uint16_t n = 0;
+	int c;
+
+	if (!p || !p->buffered) {
+		return;
+	}
+
+	while (!huart->STA->UTXBF && (c = RingBuffer_GetChar(&p->tx)) >= 0) {
+		*huart->TXREG = c;
+		n++;
+	}
+
+	// Nothing left to send, UART_Write() kicks it again
+	if (RingBuffer_Empty(&p->tx)) {
+		UART_SetIRQ(p->index, UART_IRQ_TX, false);
+	}
+
+	p->stats.tx_bytes += n;
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (n) {
+		BaseType_t woken = pdFALSE;
+
+		RingBuffer_NotifyTxFromISR(&p->tx, &woken);
+		UART_YieldFromISR(woken);
+	}
+#endif
+}
+
+// Framing and parity errors are counted along with the data, an overrun needs the FIFO drained first
+void UART_ProcessErrInterrupt(const UART_HandleTypeDef *huart) {
+	UART_ProcessRxInterrupt(huart);
+}
+
 #endif
\ No newline at end of file
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 __extension__ typedef struct {
 	union {
@@ -84,6 +85,8 @@ typedef struct {
 	volatile uint16_t *BRG;
 	volatile uint16_t *TXREG;
 	volatile uint16_t *RXREG;
+	uint8_t DMA_RX_TRIGGER;	// UxRX and UxTX IRQ numbers, 0 to never use DMA
+	uint8_t DMA_TX_TRIGGER;
 } UART_HandleTypeDef;
 
 enum {
@@ -103,4 +106,121 @@ extern const UART_HandleTypeDef huart3;
 extern void UART_Initialize(const UART_HandleTypeDef *huart, uint16_t uart_mode, uint16_t speed);
 extern void UART_SetSpeed(const UART_HandleTypeDef *huart, uint16_t speed);
 extern void UART_Transmit(const UART_HandleTypeDef *huart, const uint8_t *buf, uint16_t len);
-extern uint16_t UART_Receive(const UART_HandleTypeDef *huart, uint8_t *buf, uint16_t len);
\ No newline at end of file
+extern uint16_t UART_Receive(const UART_HandleTypeDef *huart, uint8_t *buf, uint16_t len);
+
+/*
+ * Interrupt driven mode. UART_StartBuffered() gives a port an RX and a TX
+ * ring, fed by its interrupts, and from then on UART_Write()/UART_Read() (and
+ * so write()/read() on its fd) go through them. With the scheduler running
+ * they block on task notifications, a write until everything is queued, a
+ * read until at least one byte arrived or the read timeout expired.
+ *
+ * UART_Transmit()/UART_Receive() keep polling the hardware, for bare metal
+ * builds and ports left in polling mode. Don't mix them with a buffered port.
+ * Only 8-bit data is supported in buffered mode.
+ *
+ * The board routes the RX, TX and error interrupts of every UART to the
+ * UART_Process*Interrupt() functions. With FreeRTOS they are moved to the
+ * kernel priority, as they wake tasks.
+ */
+
+typedef struct {
+	uint32_t rx_bytes;
+	uint32_t tx_bytes;
+	uint16_t overrun;	// Hardware FIFO overflowed, OERR
+	uint16_t framing;	// FERR
+	uint16_t parity;	// PERR
+	uint16_t rx_dropped;	// RX ring full
+	uint32_t frames;
+	uint16_t frames_dropped;	// Frame queue or RX ring full
+	uint16_t throttled;	// RTS deasserted at the high watermark
+	uint16_t tx_blocked;	// A writer waited for the TX ring, e.g. held off by CTS
+} UART_Stats;
+
+extern bool UART_StartBuffered(const UART_HandleTypeDef *huart, uint16_t rx_size, uint16_t tx_size);
+extern bool UART_IsBuffered(const UART_HandleTypeDef *huart);
+
+#ifdef PICo24_Enable_Peripheral_DMA
+/*
+ * Buffered mode with the rings moved by DMA: RX is a circular transfer into
+ * the RX ring, looked at when reading and every half ring, and TX sends the
+ * TX ring a span at a time. Each direction falls back to interrupts if it
+ * gets no channel. Not for framed ports, RTS watermarks or counting framing
+ * and parity errors, which all need the RX interrupt.
+ */
+extern bool UART_StartDMA(const UART_HandleTypeDef *huart, uint16_t rx_size, uint16_t tx_size);
+#endif
+
+// 0 waits forever, which is the default
+extern void UART_SetReadTimeout(const UART_HandleTypeDef *huart, uint32_t timeout_ms);
+
+// Fall back to UART_Transmit()/UART_Receive() on ports in polling mode
+extern uint16_t UART_Write(const UART_HandleTypeDef *huart, const uint8_t *buf, uint16_t len);
+extern uint16_t UART_Read(const UART_HandleTypeDef *huart, uint8_t *buf, uint16_t len);
+
+// Waits until the TX ring and the hardware are empty
+extern void UART_Drain(const UART_HandleTypeDef *huart);
+
+/*
+ * RTS/CTS flow control for buffered ports, initialized with UART_CRTSCTS.
+ * CTS is left to the hardware, which holds the transmitter while it's
+ * deasserted, and the TX interrupt just doesn't come until it moves again.
+ *
+ * RTS follows the RX ring: deasserted once it holds high bytes, asserted
+ * again when a read brings it down to low (0 for 3/4 and 1/4 of the ring).
+ * With rts_lat set, RTS is a plain output pin, active low, and the ring
+ * space above high is what the peer has to stop within. Otherwise it stays
+ * the UART's own (mapped) RTS, the RX interrupt stops emptying the FIFO and
+ * the hardware deasserts it when that fills, which only leaves the peer one
+ * character, so prefer a pin at 1M baud and above.
+ */
+extern bool UART_SetFlowControl(const UART_HandleTypeDef *huart, volatile uint16_t *rts_lat, uint16_t rts_mask, uint16_t high, uint16_t low);
+
+extern bool UART_GetStats(const UART_HandleTypeDef *huart, UART_Stats *stats);
+extern void UART_ResetStats(const UART_HandleTypeDef *huart);
+
+/*
+ * Frame mode, on top of the buffered one, for request/response protocols
+ * like Modbus RTU. A frame ends when the line stays idle for a gap of some
+ * character times (3.5 for Modbus, 1.5 for its inter-character limit), and
+ * every UART_ReadFrame() (or read()) returns exactly one frame.
+ *
+ * RIDLE only says no character is being received right now, so the gap is
+ * timed with an Alarm instead, armed once per gap rather than once per byte.
+ * Needs the TIMER peripheral, with the Timebase and the Alarms initialized.
+ *
+ * A frame that doesn't fit in the RX ring or the frame queue is dropped
+ * whole. Stamps are PICo24_CycleStamp() values taken in the RX interrupt.
+ */
+
+#ifndef PICo24_UART_FrameQueue
+#define PICo24_UART_FrameQueue		8	// Power of 2
+#endif
+
+enum {
+	UART_FRAME_ERROR = 0x1,		// Framing or parity error on some byte
+	UART_FRAME_TRUNCATED = 0x2,	// Didn't fit in the caller's buffer, the rest was discarded
+	UART_FRAME_OVERFLOW = 0x4,	// Internal, the frame is being dropped
+};
+
+typedef struct {
+	uint16_t len;
+	uint8_t flags;
+	uint32_t start;		// First and last byte
+	uint32_t end;
+} UART_Frame;
+
+#ifdef PICo24_Enable_Peripheral_TIMER
+
+// gap_tenths is in tenths of a character time at the current speed and format, 0 means 35
+extern bool UART_StartFrames(const UART_HandleTypeDef *huart, uint16_t rx_size, uint16_t tx_size, uint16_t gap_tenths);
+// Fixed gap instead, e.g. Modbus asks for 1750us above 19200 baud
+extern void UART_SetFrameGap(const UART_HandleTypeDef *huart, uint32_t gap_us);
+// Waits up to the read timeout, returns the number of bytes stored
+extern uint16_t UART_ReadFrame(const UART_HandleTypeDef *huart, uint8_t *buf, uint16_t len, UART_Frame *info);
+
+#endif
+
+extern void UART_ProcessRxInterrupt(const UART_HandleTypeDef *huart);
+extern void UART_ProcessTxInterrupt(const UART_HandleTypeDef *huart);
+extern void UART_ProcessErrInterrupt(const UART_HandleTypeDef *huart);
\ No newline at end of file
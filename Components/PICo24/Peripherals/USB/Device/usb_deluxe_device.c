@@ -26,6 +26,7 @@
 #include <PICo24/Library/SafeMalloc.h>
 
 #include <PICo24/Core/FreeRTOS_Support.h>
+#include <PICo24/Core/Delay.h>
 
 #ifdef PICo24_Enable_Peripheral_USB_DEVICE
 
@@ -225,9 +226,27 @@ void USBDeluxe_DeviceDescriptor_InsertIAD(uint8_t iface, uint8_t nr_contiguous_i
 	Vector_PushBack2(&usb_device_desc_ctx.raw, buf0, sizeof(buf0));
 }
 
+#ifdef PICo24_FreeRTOS_Enabled
+// Endpoints up to here belong to the functions added before
+static uint8_t usb_device_driver_last_ep = 1;
+
+static BaseType_t usb_device_task_woken = pdFALSE;
+#endif
+
 USBDeviceDriverContext *USBDeluxe_DeviceDriver_AllocateMemory(uint8_t usb_func) {
 	USBDeviceDriverContext *ctx = Vector_EmplaceBack(&usb_device_driver_ctx);
 
+	memset(ctx, 0, sizeof(USBDeviceDriverContext));
+
+#ifdef PICo24_FreeRTOS_Enabled
+	// Functions insert their endpoint descriptors before allocating the context
+	for (uint8_t i=usb_device_driver_last_ep; i<usb_device_desc_ctx.used_endpoints; i++) {
+		ctx->ep_mask |= 1 << i;
+	}
+
+	usb_device_driver_last_ep = usb_device_desc_ctx.used_endpoints;
+#endif
+
 	switch (usb_func) {
 #ifdef PICo24_Enable_Peripheral_USB_DEVICE_HID
 		case USB_FUNC_HID:
@@ -427,6 +446,9 @@ void USBDeluxe_Device_Task(void *p) {
 	taskEXIT_CRITICAL();
 
 	while (1) {
+		// Set when the function has more to do without waiting for the host
+		bool busy = false;
+
 //		printf("ut\n");
 //		vTaskSuspendAll();
 
@@ -465,7 +487,9 @@ void USBDeluxe_Device_Task(void *p) {
 #endif
 #ifdef PICo24_Enable_Peripheral_USB_DEVICE_MSD
 			case USB_FUNC_MSD:
-				USBDeluxeDevice_MSD_Tasks(drv_ctx->drv_ctx);
+				// The MSD state machine steps from a CBW to the data and CSW
+				// stages without any endpoint event in between
+				busy = USBDeluxeDevice_MSD_Tasks(drv_ctx->drv_ctx) != MSD_WAIT;
 				break;
 #endif
 			default:
@@ -479,19 +503,157 @@ void USBDeluxe_Device_Task(void *p) {
 //			taskYIELD();
 //		}
 
-		taskYIELD();
+		if (busy) {
+			taskYIELD();
+			continue;
+		}
+
+		if (ulTaskNotifyTake(pdTRUE, PICo24_USB_Device_TaskIdleTicks)) {
+			taskENTER_CRITICAL();
+			if (drv_ctx->notify_stamp) {
+				uint32_t latency = PICo24_RunTimeCounter() - drv_ctx->notify_stamp;
+
+				drv_ctx->notify_stamp = 0;
+				drv_ctx->latency_last = latency;
+				drv_ctx->latency_total += latency;
+
+				if (latency > drv_ctx->latency_max) {
+					drv_ctx->latency_max = latency;
+				}
+			}
+			drv_ctx->wakeups++;
+			taskEXIT_CRITICAL();
+		} else {
+			drv_ctx->timeouts++;
+		}
 
 //		taskEXIT_CRITICAL();
 	}
 }
+
+// Only the first notification before the task runs is timed
+static inline void USBDeluxe_Device_Stamp(USBDeviceDriverContext *drv_ctx) {
+	if (!drv_ctx->notify_stamp) {
+		drv_ctx->notify_stamp = PICo24_RunTimeCounter() | 1;
+	}
+}
+
+void USBDeluxe_Device_Notify(void *drv_ctx) {
+	for (size_t i=0; i<usb_device_driver_ctx.size; i++) {
+		USBDeviceDriverContext *ctx = USBDeluxe_DeviceGetDriverContext(i);
+
+		if (ctx->drv_ctx == drv_ctx) {
+			if (ctx->task) {
+				taskENTER_CRITICAL();
+				USBDeluxe_Device_Stamp(ctx);
+				taskEXIT_CRITICAL();
+				xTaskNotifyGive(ctx->task);
+			}
+			return;
+		}
+	}
+}
+
+// Called from the USB ISR, which runs at the kernel interrupt priority
+void USBDeluxe_Device_NotifyEndpointFromISR(uint8_t ep) {
+	for (size_t i=0; i<usb_device_driver_ctx.size; i++) {
+		USBDeviceDriverContext *ctx = USBDeluxe_DeviceGetDriverContext(i);
+
+		if (ctx->task && (ctx->ep_mask & (1 << ep))) {
+			USBDeluxe_Device_Stamp(ctx);
+			vTaskNotifyGiveFromISR(ctx->task, &usb_device_task_woken);
+		}
+	}
+}
+
+void USBDeluxe_Device_NotifyAllFromISR() {
+	for (size_t i=0; i<usb_device_driver_ctx.size; i++) {
+		USBDeviceDriverContext *ctx = USBDeluxe_DeviceGetDriverContext(i);
+
+		if (ctx->task) {
+			USBDeluxe_Device_Stamp(ctx);
+			vTaskNotifyGiveFromISR(ctx->task, &usb_device_task_woken);
+		}
+	}
+}
+
+// Call at the end of the USB ISR, after all events are handled
+void USBDeluxe_Device_YieldFromISR() {
+	if (usb_device_task_woken) {
+		usb_device_task_woken = pdFALSE;
+
+		if (freertos_started) {
+			taskYIELD();
+		}
+	}
+}
+
+bool USBDeluxe_Device_GetTaskStats(uint8_t idx, USBDeviceTaskStats *stats) {
+	if (idx >= usb_device_driver_ctx.size) {
+		return false;
+	}
+
+	USBDeviceDriverContext *ctx = USBDeluxe_DeviceGetDriverContext(idx);
+
+	if (!ctx->task) {
+		return false;
+	}
+
+	taskENTER_CRITICAL();
+	uint32_t last = ctx->latency_last, max = ctx->latency_max, total = ctx->latency_total;
+	stats->wakeups = ctx->wakeups;
+	stats->timeouts = ctx->timeouts;
+	taskEXIT_CRITICAL();
+
+	stats->latency_last_us = PICo24_RunTimeToMicroseconds(last);
+	stats->latency_max_us = PICo24_RunTimeToMicroseconds(max);
+	stats->latency_total_us = PICo24_RunTimeToMicroseconds(total);
+
+	return true;
+}
+
+void USBDeluxe_Device_ResetTaskStats(uint8_t idx) {
+	if (idx >= usb_device_driver_ctx.size) {
+		return;
+	}
+
+	USBDeviceDriverContext *ctx = USBDeluxe_DeviceGetDriverContext(idx);
+
+	taskENTER_CRITICAL();
+	ctx->wakeups = 0;
+	ctx->timeouts = 0;
+	ctx->latency_last = 0;
+	ctx->latency_max = 0;
+	ctx->latency_total = 0;
+	taskEXIT_CRITICAL();
+}
 #endif
 
+// 0 means the default, indexed by USBFunction
+static uint16_t usb_device_task_stack_size[USB_FUNC_CDC_NCM + 1];
+
+void USBDeluxe_Device_SetTaskStackSize(uint8_t usb_func, uint16_t words) {
+	if (usb_func <= USB_FUNC_CDC_NCM) {
+		usb_device_task_stack_size[usb_func] = words;
+	}
+}
+
+uint16_t USBDeluxe_Device_GetTaskStackSize(uint8_t usb_func) {
+	if (usb_func <= USB_FUNC_CDC_NCM && usb_device_task_stack_size[usb_func]) {
+		return usb_device_task_stack_size[usb_func];
+	}
+
+	return PICo24_USB_Device_TaskStackSize;
+}
+
 void USBDeluxe_Device_TaskCreate(uint16_t idx, const char *tag) {
 	char name[16];
 	sprintf(name, "USB %u: %s", idx, tag);
 
 #ifdef PICo24_FreeRTOS_Enabled
-	xTaskCreate(USBDeluxe_Device_Task, name, 384, (void *)idx, 3, NULL);
+	USBDeviceDriverContext *ctx = USBDeluxe_DeviceGetDriverContext(idx);
+
+	xTaskCreate(USBDeluxe_Device_Task, name, USBDeluxe_Device_GetTaskStackSize(ctx->func), (void *)idx, 3, &ctx->task);
 #endif
 }
 
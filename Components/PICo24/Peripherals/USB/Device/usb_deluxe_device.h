@@ -33,6 +33,8 @@
 #include "usb_deluxe_device_cdc_ecm.h"
 #include "usb_deluxe_device_cdc_ncm.h"
 
+#include <PICo24/Core/FreeRTOS_Support.h>
+
 
 typedef enum {
 	USB_EP_DIR_IN = 0x1,
@@ -54,9 +56,47 @@ typedef struct {
 	uint16_t string[USBDeviceStringDescriptor_FieldSize];
 } USBDeviceStringDescriptor;
 
+#ifdef PICo24_FreeRTOS_Enabled
+/*
+ * Function tasks sleep until the USB ISR reports a finished transaction on one
+ * of their endpoints, or until the user side hands them work through
+ * USBDeluxe_Device_Notify(). If neither happens for this many ticks they run
+ * anyway, which covers buffers filled behind the driver's back. A function
+ * that is midway through a request (MSD between the CBW and the CSW) keeps
+ * running without sleeping until it is done.
+ */
+#ifndef PICo24_USB_Device_TaskIdleTicks
+#define PICo24_USB_Device_TaskIdleTicks		50
+#endif
+
+// Stack of every function task, in words. USBDeluxe_Device_SetTaskStackSize()
+// overrides it per function type, before the function is added.
+#ifndef PICo24_USB_Device_TaskStackSize
+#define PICo24_USB_Device_TaskStackSize		384
+#endif
+
+typedef struct {
+	uint16_t wakeups;		// Woken by a notification
+	uint16_t timeouts;		// Woken by the idle timeout
+	uint32_t latency_last_us;	// Notification to the task running
+	uint32_t latency_max_us;
+	uint32_t latency_total_us;
+} USBDeviceTaskStats;
+#endif
+
 typedef struct {
 	uint16_t func;
 	void *drv_ctx;
+#ifdef PICo24_FreeRTOS_Enabled
+	TaskHandle_t task;
+	uint16_t ep_mask;		// Endpoints owned by this function
+	uint32_t notify_stamp;		// Run time counter at the first pending notification, 0 if none
+	uint16_t wakeups;
+	uint16_t timeouts;
+	uint32_t latency_last;		// In run time counter units
+	uint32_t latency_max;
+	uint32_t latency_total;
+#endif
 } USBDeviceDriverContext;
 
 extern USB_DEVICE_DESCRIPTOR usb_device_desc;
@@ -84,6 +124,18 @@ extern USBDeviceDriverContext *USBDeluxe_DeviceDriver_AllocateMemory(uint8_t usb
 extern void USBDeluxe_Device_Tasks();
 
 extern void USBDeluxe_Device_TaskCreate(uint16_t idx, const char *tag);
+extern void USBDeluxe_Device_SetTaskStackSize(uint8_t usb_func, uint16_t words);
+extern uint16_t USBDeluxe_Device_GetTaskStackSize(uint8_t usb_func);
+
+#ifdef PICo24_FreeRTOS_Enabled
+extern void USBDeluxe_Device_Notify(void *drv_ctx);
+extern void USBDeluxe_Device_NotifyEndpointFromISR(uint8_t ep);
+extern void USBDeluxe_Device_NotifyAllFromISR();
+extern void USBDeluxe_Device_YieldFromISR();
+
+extern bool USBDeluxe_Device_GetTaskStats(uint8_t idx, USBDeviceTaskStats *stats);
+extern void USBDeluxe_Device_ResetTaskStats(uint8_t idx);
+#endif
 
 extern uint8_t USBDeluxe_DeviceDescriptor_InsertInterface(uint8_t alternate_setting, uint8_t nr_endpoints, uint8_t class, uint8_t subclass, uint8_t protocol);
 extern void USBDeluxe_DeviceDescriptor_InsertEndpointRaw(uint8_t addr, uint8_t attr, uint16_t size, uint8_t interval,
@@ -155,6 +155,10 @@ int USBDeluxeDevice_Audio_Write(USBDeluxeDevice_AudioContext *audio_ctx, uint8_t
 
 	audio_ctx->HandleTx = USBTxOnePacket(audio_ctx->USB_EP_AS, buf, len);
 
+#ifdef PICo24_FreeRTOS_Enabled
+	USBDeluxe_Device_Notify(audio_ctx);
+#endif
+
 	return 0;
 }
 
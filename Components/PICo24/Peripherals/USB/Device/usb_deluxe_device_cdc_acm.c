@@ -273,6 +273,11 @@ int USBDeluxeDevice_CDC_ACM_AcquireRxBuffer(USBDeluxeDevice_CDCACMContext *cdc_c
 void USBDeluxeDevice_CDC_ACM_AdvanceRxBuffer(USBDeluxeDevice_CDCACMContext *cdc_ctx) {
 	uint8_t idx;
 	xQueueReceive(cdc_ctx->rx_queue, &idx, UINT16_MAX);
+
+	// A received buffer may be waiting for the queue slot
+	if (cdc_ctx->rx_queue_pending) {
+		USBDeluxe_Device_Notify(cdc_ctx);
+	}
 }
 
 ssize_t USBDeluxeDevice_CDC_ACM_Read(USBDeluxeDevice_CDCACMContext *cdc_ctx, uint8_t *buf, size_t len) {
@@ -335,6 +340,10 @@ ssize_t USBDeluxeDevice_CDC_ACM_Write(USBDeluxeDevice_CDCACMContext *cdc_ctx, ui
 	memcpy(user_buf.buf, buf, len);
 	*user_buf.buf_len = len;
 
+#ifdef PICo24_FreeRTOS_Enabled
+	USBDeluxe_Device_Notify(cdc_ctx);
+#endif
+
 	return len;
 }
 
@@ -225,6 +225,11 @@ int USBDeluxeDevice_CDC_ECM_AcquireRxBuffer(USBDeluxeDevice_CDCECMContext *cdc_c
 void USBDeluxeDevice_CDC_ECM_AdvanceRxBuffer(USBDeluxeDevice_CDCECMContext *cdc_ctx) {
 	uint8_t idx;
 	xQueueReceive(cdc_ctx->rx_queue, &idx, UINT16_MAX);
+
+	// A received buffer may be waiting for the queue slot
+	if (cdc_ctx->rx_queue_pending) {
+		USBDeluxe_Device_Notify(cdc_ctx);
+	}
 }
 
 int USBDeluxeDevice_CDC_ECM_AcquireTxBuffer(USBDeluxeDevice_CDCECMContext *cdc_ctx, USBDeluxeDevice_CDC_UserBuffer *user_buf) {
@@ -283,6 +288,8 @@ ssize_t USBDeluxeDevice_CDC_ECM_Write(USBDeluxeDevice_CDCECMContext *cdc_ctx, ui
 	memcpy(user_buf.buf, buf, len);
 	*user_buf.buf_len = len;
 
+	USBDeluxe_Device_Notify(cdc_ctx);
+
 	return len;
 }
 
@@ -257,9 +257,17 @@ int USBDeluxeDevice_CDC_NCM_AcquireRxBuffer(USBDeluxeDevice_CDCNCMContext *cdc_c
 void USBDeluxeDevice_CDC_NCM_AdvanceRxBuffer(USBDeluxeDevice_CDCNCMContext *cdc_ctx) {
 	uint8_t idx;
 	xQueueReceive(cdc_ctx->rx_queue, &idx, UINT16_MAX);
+
+	// A received buffer may be waiting for the queue slot
+	if (cdc_ctx->rx_queue_pending) {
+		USBDeluxe_Device_Notify(cdc_ctx);
+	}
 }
 
 int USBDeluxeDevice_CDC_NCM_AcquireTxBuffer(USBDeluxeDevice_CDCNCMContext *cdc_ctx, USBDeluxeDevice_CDC_UserBuffer *user_buf) {
+	// Write() fills several buffers in a row, get the previous one going
+	USBDeluxe_Device_Notify(cdc_ctx);
+
 	if (xSemaphoreTake(cdc_ctx->tx_lock, UINT16_MAX)) {
 		user_buf->buf = cdc_ctx->tx_buf[cdc_ctx->tx_buf_idx];
 		user_buf->buf_len = &cdc_ctx->tx_buf_len[cdc_ctx->tx_buf_idx];
@@ -294,6 +302,15 @@ ssize_t USBDeluxeDevice_CDC_NCM_ReadRaw(USBDeluxeDevice_CDCNCMContext *cdc_ctx,
 	}
 }
 
+// Forgets the NTB being parsed, but keeps the buffer's storage for the next one
+static void USBDeluxeDevice_CDC_NCM_ResetNTB(USBDeluxeDevice_CDCNCMContext *cdc_ctx) {
+	Vector buffer = cdc_ctx->ntb_context.buffer;
+
+	Vector_ClearKeepStorage(&buffer);
+	memset(&cdc_ctx->ntb_context, 0, sizeof(cdc_ctx->ntb_context));
+	cdc_ctx->ntb_context.buffer = buffer;
+}
+
 ssize_t USBDeluxeDevice_CDC_NCM_Read(USBDeluxeDevice_CDCNCMContext *cdc_ctx, uint8_t *buf, size_t len) {
 	USBDeluxeDevice_CDC_UserBuffer user_buf;
 
@@ -411,9 +428,7 @@ ssize_t USBDeluxeDevice_CDC_NCM_Read(USBDeluxeDevice_CDCNCMContext *cdc_ctx, uin
 	}
 
 free_ntb_and_return:
-	Vector_Clear(&cdc_ctx->ntb_context.buffer);
-	memset(&cdc_ctx->ntb_context, 0, sizeof(cdc_ctx->ntb_context));
-	Vector_Init(&cdc_ctx->ntb_context.buffer, 1);
+	USBDeluxeDevice_CDC_NCM_ResetNTB(cdc_ctx);
 	printf("NCM_Read: reset\n");
 
 	return ret;
@@ -477,9 +492,7 @@ ssize_t USBDeluxeDevice_CDC_NCM_ReadOS(USBDeluxeDevice_CDCNCMContext *cdc_ctx, u
 			) {
 			// Clean up
 			printf("!!! CLEANUP %02x, %02x\n", cdc_ctx->ntb_context.buffer.size, cdc_ctx->ntb_context.header_total_length);
-			Vector_Clear(&cdc_ctx->ntb_context.buffer);
-			memset(&cdc_ctx->ntb_context, 0, sizeof(cdc_ctx->ntb_context));
-			Vector_Init(&cdc_ctx->ntb_context.buffer, 1);
+			USBDeluxeDevice_CDC_NCM_ResetNTB(cdc_ctx);
 		}
 
 		if (USBDeluxeDevice_CDC_NCM_AcquireRxBuffer(cdc_ctx, &user_buf) != 0) {
@@ -598,6 +611,8 @@ ssize_t USBDeluxeDevice_CDC_NCM_Write(USBDeluxeDevice_CDCNCMContext *cdc_ctx, ui
 
 	cdc_ctx->ntb_tx_seq++;
 
+	USBDeluxe_Device_Notify(cdc_ctx);
+
 	return processed_len;
 }
 
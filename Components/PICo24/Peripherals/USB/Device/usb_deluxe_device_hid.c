@@ -152,6 +152,10 @@ int USBDeluxeDevice_HID_Write(USBDeluxeDevice_HIDContext *hid_ctx, uint8_t *buf,
 
 	hid_ctx->HandleTx = USBTxOnePacket(hid_ctx->USB_EP, buf, len);
 
+#ifdef PICo24_FreeRTOS_Enabled
+	USBDeluxe_Device_Notify(hid_ctx);
+#endif
+
 	return 0;
 }
 
@@ -78,6 +78,10 @@ int USBDeluxeDevice_MIDI_Write(USBDeluxeDevice_MIDIContext *midi_ctx, uint8_t *b
 
 	midi_ctx->HandleTx = USBTxOnePacket(midi_ctx->USB_EP_MS, buf, len);
 
+#ifdef PICo24_FreeRTOS_Enabled
+	USBDeluxe_Device_Notify(midi_ctx);
+#endif
+
 	return 0;
 }
 
@@ -71,6 +71,8 @@
 #include "usb_device.h"
 #include "usb_device_local.h"
 
+#include <PICo24/Core/Trace.h>
+
 #ifndef uintptr_t
 #if  defined(__XC8__) || defined(__XC16__)
 #define uintptr_t uint16_t
@@ -768,6 +770,7 @@ void USBDeviceTasks(void) {
 				//Save and extract USTAT register info.  Will use this info later.
 				USTATcopy.Val = U1STAT;
 				endpoint_number = USBHALGetLastEndpoint(USTATcopy);
+				PICo24_TRACE(TRACE_EV_USB_TRANSFER, USTATcopy.Val, 0);
 
 				USBClearInterruptFlag(USBTransactionCompleteIFReg,USBTransactionCompleteIFBitNum);
 
@@ -68,6 +68,9 @@ bool USB_Device_EventHandler(USB_EVENT event, void *pdata, uint16_t size) {
 	switch( (int) event )
 	{
 		case EVENT_TRANSFER:
+#ifdef PICo24_FreeRTOS_Enabled
+			USBDeluxe_Device_NotifyEndpointFromISR(USBHALGetLastEndpoint((*(USTAT_FIELDS *)pdata)));
+#endif
 			break;
 
 		case EVENT_SOF:
@@ -87,10 +90,16 @@ bool USB_Device_EventHandler(USB_EVENT event, void *pdata, uint16_t size) {
 			//restore I/O pins to higher power states if they were changed during the
 			//preceding SYSTEM_Initialize(SYSTEM_STATE_USB_SUSPEND) call at the start
 			//of the suspend condition.
+#ifdef PICo24_FreeRTOS_Enabled
+			USBDeluxe_Device_NotifyAllFromISR();
+#endif
 			break;
 
 		case EVENT_CONFIGURED:
 			USBDeluxe_Device_EventInit();
+#ifdef PICo24_FreeRTOS_Enabled
+			USBDeluxe_Device_NotifyAllFromISR();
+#endif
 
 //			if (usb_device_functions_enabled & USB_FUNC_CDC)
 //				CDCInitEP();
@@ -22,10 +22,14 @@
 
 #ifdef PICo24_Enable_Peripheral_USB_HOST
 
-Vector hidhost_report_interface_ids = {
-	.size = 0,
-	.element_size = sizeof(uint8_t),
-	.data = NULL
+SortedSet hidhost_report_interface_ids = {
+	.vec = {
+		.size = 0,
+		.element_size = sizeof(uint8_t),
+		.data = NULL
+	},
+	.key_size = sizeof(uint8_t),
+	.compare = NULL
 };
 
 USBDeluxeHost_HIDContext usbdeluxe_host_hid_ctx = {0};
@@ -72,7 +76,7 @@ void USBDeluxeHost_HID_ReportDescHandler() {
 			usbdeluxe_host_hid_ctx.ops.ReportDescription(usbdeluxe_host_hid_ctx.userp, iface, reportItem);
 		}
 
-		Set_Insert(&hidhost_report_interface_ids, &iface);
+		SortedSet_Insert(&hidhost_report_interface_ids, &iface);
 
 	}
 }
@@ -84,8 +88,8 @@ void USBDeluxeHost_HID_Tasks(uint8_t dev_addr) {
 		return;
 	}
 
-	usbdeluxe_host_hid_ctx.current_interface_pos %= hidhost_report_interface_ids.size;
-	uint8_t interface_id = Variant_AsUint8(Vector_At(&hidhost_report_interface_ids, usbdeluxe_host_hid_ctx.current_interface_pos));
+	usbdeluxe_host_hid_ctx.current_interface_pos %= hidhost_report_interface_ids.vec.size;
+	uint8_t interface_id = Variant_AsUint8(SortedSet_At(&hidhost_report_interface_ids, usbdeluxe_host_hid_ctx.current_interface_pos));
 
 	if (usbdeluxe_host_hid_ctx.task_state == 0) {
 		uint8_t rc = USBHostHIDRead(dev_addr, 0, interface_id, 64, usbdeluxe_host_hid_ctx.report_data);
@@ -24,7 +24,7 @@
 #include "usb_host_hid.h"
 
 #include <PICo24/Library/Vector.h>
-#include <PICo24/Library/Set.h>
+#include <PICo24/Library/SortedSet.h>
 #include <PICo24/Library/Variant.h>
 
 #include <stdio.h>
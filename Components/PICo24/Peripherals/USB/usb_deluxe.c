@@ -55,6 +55,10 @@ void USBDeluxe_SetRole(uint8_t role) {
 #endif
 
 		if (role == USB_ROLE_DEVICE) {
+#ifdef PICo24_FreeRTOS_Enabled
+			// The ISR notifies the function tasks, so it must not preempt the kernel
+			_USB1IP = configKERNEL_INTERRUPT_PRIORITY;
+#endif
 			USBDeviceInit();
 			USBDeviceAttach();
 		}
@@ -52,6 +52,8 @@
 
 #include "usb_common.h"
 
+#include <PICo24/Core/Latency.h>
+
 /*****************************************************************************/
 /****** Constant definitions *************************************************/
 /*****************************************************************************/
@@ -318,8 +320,8 @@ typedef union _POINTER
 #define ConvertToVirtualAddress(a)  ((void *)(a))
 #define USBClearUSBInterrupt() IFS5bits.USB1IF = 0;
 #if defined(USB_INTERRUPT)
-    #define USBMaskInterrupts() {IEC5bits.USB1IE = 0;}
-    #define USBUnmaskInterrupts() {IEC5bits.USB1IE = 1;}
+    #define USBMaskInterrupts() {IEC5bits.USB1IE = 0; PICo24_LATENCY_ENTER(LATENCY_USB_MASK);}
+    #define USBUnmaskInterrupts() {PICo24_LATENCY_EXIT(LATENCY_USB_MASK); IEC5bits.USB1IE = 1;}
 #else
     #define USBMaskInterrupts() 
     #define USBUnmaskInterrupts() 
@@ -113,18 +113,15 @@ static ssize_t write_uart(int fd, const void *buf, size_t count) {
 	switch (fd) {
 #ifdef PINFUNC_UART1_TX
 		case UART1_FILENO:
-			UART_Transmit(&huart1, (uint8_t *) buf, count);
-			return count;
+			return UART_Write(&huart1, (uint8_t *) buf, count);
 #endif
 #ifdef PINFUNC_UART2_TX
 		case UART2_FILENO:
-			UART_Transmit(&huart2, (uint8_t *) buf, count);
-			return count;
+			return UART_Write(&huart2, (uint8_t *) buf, count);
 #endif
 #ifdef PINFUNC_UART3_TX
 		case UART3_FILENO:
-			UART_Transmit(&huart3, (uint8_t *) buf, count);
-			return count;
+			return UART_Write(&huart3, (uint8_t *) buf, count);
 #endif
 		default:
 			break;
@@ -137,15 +134,15 @@ static ssize_t read_uart(int fd, void *buf, size_t count) {
 	switch (fd) {
 #ifdef PINFUNC_UART1_TX
 		case UART1_FILENO:
-			return UART_Receive(&huart1, (uint8_t *)buf, count);
+			return UART_Read(&huart1, (uint8_t *)buf, count);
 #endif
 #ifdef PINFUNC_UART2_TX
 		case UART2_FILENO:
-			return UART_Receive(&huart2, (uint8_t *)buf, count);
+			return UART_Read(&huart2, (uint8_t *)buf, count);
 #endif
 #ifdef PINFUNC_UART3_TX
 		case UART3_FILENO:
-			return UART_Receive(&huart3, (uint8_t *)buf, count);
+			return UART_Read(&huart3, (uint8_t *)buf, count);
 #endif
 		default:
 			return -1;
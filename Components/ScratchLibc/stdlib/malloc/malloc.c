@@ -19,37 +19,586 @@
 
 #include "malloc.h"
 
+#include <string.h>
+
+#include <PICo24/Core/Trace.h>
+
+#ifdef PICo24_FreeRTOS_Enabled
+#include <PICo24/Core/FreeRTOS_Support.h>
+#endif
+
+typedef struct {
+	uint32_t live;
+	uint32_t peak;
+	uint16_t failures;
+	uint16_t alloc_hist[MALLOC_STATS_HIST_BINS];
+} malloc_heap_counters;
+
+#ifdef __HAS_EDS__
+static malloc_heap_counters malloc_counters[2];
+#else
+static malloc_heap_counters malloc_counters[1];
+#endif
+
+// Entry 0 is for everything that can't be attributed to a task
+static malloc_task_stats malloc_tasks[MALLOC_STATS_TASKS];
+
+static uint8_t malloc_stats_bin(uint32_t size) {
+	uint8_t i = 0;
+
+	if (size <= 8) {
+		return 0;
+	}
+
+	size = (size - 1) >> 3;
+
+	while (size && i < MALLOC_STATS_HIST_BINS - 1) {
+		size >>= 1;
+		i++;
+	}
+
+	return i;
+}
+
+// Must be called with UMM_CRITICAL_ENTRY() held
+static malloc_task_stats *malloc_stats_task() {
+	void *task = NULL;
+
+#ifdef PICo24_FreeRTOS_Enabled
+	if (freertos_started) {
+		task = xTaskGetCurrentTaskHandle();
+	}
+#endif
+
+	if (task) {
+		for (uint8_t i=1; i<MALLOC_STATS_TASKS; i++) {
+			if (malloc_tasks[i].task == task) {
+				return &malloc_tasks[i];
+			} else if (!malloc_tasks[i].task) {
+				malloc_tasks[i].task = task;
+				return &malloc_tasks[i];
+			}
+		}
+	}
+
+	return &malloc_tasks[0];
+}
+
+// `bytes` is the size of the block that was allocated (> 0) or released (< 0)
+static void malloc_stats_account(uint8_t heap, int32_t bytes) {
+	malloc_heap_counters *c = &malloc_counters[heap];
+
+	if (bytes > 0) {
+		PICo24_TRACE(TRACE_EV_MALLOC, heap, bytes);
+	} else {
+		PICo24_TRACE(TRACE_EV_FREE, heap, -bytes);
+	}
+
+	UMM_CRITICAL_ENTRY();
+
+	c->live += bytes;
+
+	if (c->live > c->peak) {
+		c->peak = c->live;
+	}
+
+	malloc_task_stats *t = malloc_stats_task();
+
+	if (heap == MALLOC_HEAP_NEAR) {
+		t->live += bytes;
+
+		if (t->live > 0 && (uint32_t)t->live > t->peak) {
+			t->peak = t->live;
+		}
+	}
+#ifdef __HAS_EDS__
+	else {
+		t->live_eds += bytes;
+
+		if (t->live_eds > 0 && (uint32_t)t->live_eds > t->peak_eds) {
+			t->peak_eds = t->live_eds;
+		}
+	}
+#endif
+
+	UMM_CRITICAL_EXIT();
+}
+
+static void malloc_stats_request(uint8_t heap, uint32_t size, bool ok) {
+	malloc_heap_counters *c = &malloc_counters[heap];
+
+	UMM_CRITICAL_ENTRY();
+
+	c->alloc_hist[malloc_stats_bin(size)]++;
+
+	if (!ok) {
+		c->failures++;
+	}
+
+	UMM_CRITICAL_EXIT();
+}
+
+#if MALLOC_CACHE_DEPTH
+
+typedef struct {
+	void *head;
+	uint16_t count;
+	uint16_t hits;
+	uint16_t misses;
+} malloc_cache_class;
+
+static const uint16_t malloc_cache_sizes[MALLOC_CACHE_CLASSES] = {8, 16, 32, 64, 128, 256};
+static uint16_t malloc_cache_blocks[MALLOC_CACHE_CLASSES];
+static malloc_cache_class malloc_cache[MALLOC_CACHE_CLASSES];
+
+static int8_t malloc_cache_class_of_size(size_t size) {
+	for (uint8_t i=0; i<MALLOC_CACHE_CLASSES; i++) {
+		if (size <= malloc_cache_sizes[i]) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+// A freed block can go to a class only if it has exactly the number of umm blocks that class allocates
+static int8_t malloc_cache_class_of_blocks(uint16_t blocks) {
+	if (!malloc_cache_blocks[0]) {
+		for (uint8_t i=0; i<MALLOC_CACHE_CLASSES; i++) {
+			malloc_cache_blocks[i] = umm_size_to_blocks(malloc_cache_sizes[i]);
+		}
+	}
+
+	for (uint8_t i=0; i<MALLOC_CACHE_CLASSES; i++) {
+		if (blocks == malloc_cache_blocks[i]) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+#endif
+
 void __attribute__((__section__(".libc"))) *malloc(size_t size) {
-	return umm_malloc(size);
+	void *ret = NULL;
+	size_t req = size;
+
+#if MALLOC_CACHE_DEPTH
+	int8_t k = malloc_cache_class_of_size(size);
+
+	if (size && k >= 0) {
+		malloc_cache_class *cls = &malloc_cache[k];
+
+		UMM_CRITICAL_ENTRY();
+
+		ret = cls->head;
+
+		if (ret) {
+			cls->head = *(void **)ret;
+			cls->count--;
+			cls->hits++;
+		} else {
+			cls->misses++;
+		}
+
+		UMM_CRITICAL_EXIT();
+
+		if (ret) {
+			malloc_stats_request(MALLOC_HEAP_NEAR, req, true);
+			malloc_stats_account(MALLOC_HEAP_NEAR, (int32_t)umm_ptr_blocks(ret) * (int32_t)sizeof(umm_block));
+			return ret;
+		}
+
+		// Allocate the whole class so the block can be recycled later
+		size = malloc_cache_sizes[k];
+	}
+#endif
+
+	ret = umm_malloc(size);
+
+	if (!ret && size && malloc_trim(0)) {
+		ret = umm_malloc(size);
+	}
+
+	malloc_stats_request(MALLOC_HEAP_NEAR, req, ret || !size);
+
+	if (ret) {
+		malloc_stats_account(MALLOC_HEAP_NEAR, (int32_t)umm_ptr_blocks(ret) * (int32_t)sizeof(umm_block));
+	}
+
+	return ret;
 }
 
 void __attribute__((__section__(".libc"))) *calloc(size_t num, size_t size) {
-	return umm_calloc(num, size);
+	size_t len = num * size;
+
+	if (size && len / size != num) {
+		return NULL;
+	}
+
+	void *ret = malloc(len);
+
+	if (ret) {
+		memset(ret, 0, len);
+	}
+
+	return ret;
 }
 
 void __attribute__((__section__(".libc"))) *realloc(void *ptr, size_t size) {
-	return umm_realloc(ptr, size);
+	int32_t old_bytes = ptr ? (int32_t)umm_ptr_blocks(ptr) * (int32_t)sizeof(umm_block) : 0;
+
+	void *ret = umm_realloc(ptr, size);
+
+	if (!ret && size && malloc_trim(0)) {
+		ret = umm_realloc(ptr, size);
+	}
+
+	if (size) {
+		malloc_stats_request(MALLOC_HEAP_NEAR, size, ret != NULL);
+	}
+
+	// umm_realloc(ptr, 0) frees ptr, and a failed one leaves it alone
+	if (ret) {
+		malloc_stats_account(MALLOC_HEAP_NEAR, (int32_t)umm_ptr_blocks(ret) * (int32_t)sizeof(umm_block) - old_bytes);
+	} else if (!size) {
+		malloc_stats_account(MALLOC_HEAP_NEAR, -old_bytes);
+	}
+
+	return ret;
 }
 
 void __attribute__((__section__(".libc"))) free(void *ptr) {
+	if (!ptr) {
+		return;
+	}
+
+	uint16_t blocks = umm_ptr_blocks(ptr);
+
+	malloc_stats_account(MALLOC_HEAP_NEAR, -(int32_t)blocks * (int32_t)sizeof(umm_block));
+
+#if MALLOC_CACHE_DEPTH
+	int8_t k = malloc_cache_class_of_blocks(blocks);
+
+	if (k >= 0) {
+		malloc_cache_class *cls = &malloc_cache[k];
+		bool cached = false;
+
+		UMM_CRITICAL_ENTRY();
+
+		if (cls->count < MALLOC_CACHE_DEPTH) {
+			*(void **)ptr = cls->head;
+			cls->head = ptr;
+			cls->count++;
+			cached = true;
+		}
+
+		UMM_CRITICAL_EXIT();
+
+		if (cached) {
+			return;
+		}
+	}
+#endif
+
 	umm_free(ptr);
 }
 
+// Returns all cached blocks to umm, returns 1 if anything was released
+int malloc_trim(size_t pad) {
+	int ret = 0;
+
+#if MALLOC_CACHE_DEPTH
+	for (uint8_t i=0; i<MALLOC_CACHE_CLASSES; i++) {
+		malloc_cache_class *cls = &malloc_cache[i];
+
+		UMM_CRITICAL_ENTRY();
+
+		void *p = cls->head;
+		cls->head = NULL;
+		cls->count = 0;
+
+		UMM_CRITICAL_EXIT();
+
+		while (p) {
+			void *next = *(void **)p;
+			umm_free(p);
+			p = next;
+			ret = 1;
+		}
+	}
+#endif
+
+	return ret;
+}
+
+void malloc_cache_info(malloc_cache_class_info info[MALLOC_CACHE_CLASSES]) {
+	for (uint8_t i=0; i<MALLOC_CACHE_CLASSES; i++) {
+#if MALLOC_CACHE_DEPTH
+		info[i].size = malloc_cache_sizes[i];
+		info[i].cached = malloc_cache[i].count;
+		info[i].hits = malloc_cache[i].hits;
+		info[i].misses = malloc_cache[i].misses;
+#else
+		memset(&info[i], 0, sizeof(malloc_cache_class_info));
+#endif
+	}
+}
+
+static void malloc_stats_fill(malloc_heap_stats *st, uint8_t heap, uint32_t total, uint32_t free_bytes, uint32_t largest) {
+	malloc_heap_counters *c = &malloc_counters[heap];
+
+	st->heap = heap;
+	st->total = total;
+	st->free = free_bytes;
+	st->used = total - free_bytes;
+	st->largest_free = largest;
+
+	// How much of the free memory can't be handed out in one piece
+	st->fragmentation = free_bytes ? 100 - (uint8_t)(largest * 100 / free_bytes) : 0;
+
+	UMM_CRITICAL_ENTRY();
+	st->live = c->live;
+	st->peak = c->peak;
+	st->failures = c->failures;
+	memcpy(st->alloc_hist, c->alloc_hist, sizeof(c->alloc_hist));
+	UMM_CRITICAL_EXIT();
+}
+
+// Only walks the free list, so it's much cheaper than umm_info()
+void malloc_stats(malloc_heap_stats *st) {
+	uint32_t free_blocks = 0, largest = 0;
+	uint16_t entries = 0;
+
+	if (umm_heap == NULL) {
+		umm_init();
+	}
+
+	UMM_CRITICAL_ENTRY();
+
+	for (uint16_t b = UMM_NFREE(0); b; b = UMM_NFREE(b)) {
+		uint16_t n = (UMM_NBLOCK(b) & UMM_BLOCKNO_MASK) - b;
+
+		free_blocks += n;
+		entries++;
+
+		if (n > largest) {
+			largest = n;
+		}
+	}
+
+	UMM_CRITICAL_EXIT();
+
+	malloc_stats_fill(st, MALLOC_HEAP_NEAR, UMM_Heap_Size, free_blocks * sizeof(umm_block), largest * sizeof(umm_block));
+	st->free_entries = entries;
+}
+
+uint8_t malloc_task_stats_get(malloc_task_stats *st, uint8_t max) {
+	uint8_t n = 0;
+
+	UMM_CRITICAL_ENTRY();
+
+	for (uint8_t i=0; i<MALLOC_STATS_TASKS && n<max; i++) {
+		if (i && !malloc_tasks[i].task) {
+			break;
+		}
+
+		st[n++] = malloc_tasks[i];
+	}
+
+	UMM_CRITICAL_EXIT();
+
+	return n;
+}
+
+void malloc_stats_reset_peak() {
+	UMM_CRITICAL_ENTRY();
+
+	for (uint8_t i=0; i<sizeof(malloc_counters)/sizeof(malloc_heap_counters); i++) {
+		malloc_counters[i].peak = malloc_counters[i].live;
+	}
+
+	for (uint8_t i=0; i<MALLOC_STATS_TASKS; i++) {
+		malloc_tasks[i].peak = malloc_tasks[i].live > 0 ? malloc_tasks[i].live : 0;
+#ifdef __HAS_EDS__
+		malloc_tasks[i].peak_eds = malloc_tasks[i].live_eds > 0 ? malloc_tasks[i].live_eds : 0;
+#endif
+	}
+
+	UMM_CRITICAL_EXIT();
+}
+
+static uint8_t *malloc_stats_put16(uint8_t *p, uint16_t v) {
+	*p++ = v;
+	*p++ = v >> 8;
+	return p;
+}
+
+static uint8_t *malloc_stats_put32(uint8_t *p, uint32_t v) {
+	p = malloc_stats_put16(p, v);
+	return malloc_stats_put16(p, v >> 16);
+}
+
+/*
+ * Record layout, all little endian:
+ *   header: 'M' 'S' version heaps tasks 0
+ *   heap:   heap fragmentation free_entries:16 failures:16 total:32 used:32
+ *           largest_free:32 live:32 peak:32 alloc_hist:16 * MALLOC_STATS_HIST_BINS
+ *   task:   task:16 heap 0 live:32 peak:32
+ */
+
+#define MALLOC_STATS_RECORD_VERSION	1
+#define MALLOC_STATS_HEADER_SIZE	6
+#define MALLOC_STATS_HEAP_SIZE		(26 + 2 * MALLOC_STATS_HIST_BINS)
+#define MALLOC_STATS_TASK_SIZE		12
+
+static uint8_t *malloc_stats_put_heap(uint8_t *p, const malloc_heap_stats *st) {
+	*p++ = st->heap;
+	*p++ = st->fragmentation;
+	p = malloc_stats_put16(p, st->free_entries);
+	p = malloc_stats_put16(p, st->failures);
+	p = malloc_stats_put32(p, st->total);
+	p = malloc_stats_put32(p, st->used);
+	p = malloc_stats_put32(p, st->largest_free);
+	p = malloc_stats_put32(p, st->live);
+	p = malloc_stats_put32(p, st->peak);
+
+	for (uint8_t i=0; i<MALLOC_STATS_HIST_BINS; i++) {
+		p = malloc_stats_put16(p, st->alloc_hist[i]);
+	}
+
+	return p;
+}
+
+static uint8_t *malloc_stats_put_task(uint8_t *p, const malloc_task_stats *t, uint8_t heap, int32_t live, uint32_t peak) {
+	p = malloc_stats_put16(p, (uint16_t)(uintptr_t)t->task);
+	*p++ = heap;
+	*p++ = 0;
+	p = malloc_stats_put32(p, live);
+	return malloc_stats_put32(p, peak);
+}
+
+// Returns the number of bytes written, or the size needed if buf is NULL. 0 if it doesn't fit.
+size_t malloc_stats_export(void *buf, size_t len) {
+	malloc_task_stats tasks[MALLOC_STATS_TASKS];
+	malloc_heap_stats st;
+	uint8_t heaps = sizeof(malloc_counters) / sizeof(malloc_heap_counters);
+	uint8_t ntasks = malloc_task_stats_get(tasks, MALLOC_STATS_TASKS);
+	uint8_t records = ntasks * heaps;
+	size_t need = MALLOC_STATS_HEADER_SIZE + heaps * MALLOC_STATS_HEAP_SIZE + records * MALLOC_STATS_TASK_SIZE;
+
+	if (!buf) {
+		return need;
+	}
+
+	if (len < need) {
+		return 0;
+	}
+
+	uint8_t *p = buf;
+
+	*p++ = 'M';
+	*p++ = 'S';
+	*p++ = MALLOC_STATS_RECORD_VERSION;
+	*p++ = heaps;
+	*p++ = records;
+	*p++ = 0;
+
+	malloc_stats(&st);
+	p = malloc_stats_put_heap(p, &st);
+
 #ifdef __HAS_EDS__
+	malloc_stats_eds(&st);
+	p = malloc_stats_put_heap(p, &st);
+#endif
+
+	for (uint8_t i=0; i<ntasks; i++) {
+		p = malloc_stats_put_task(p, &tasks[i], MALLOC_HEAP_NEAR, tasks[i].live, tasks[i].peak);
+#ifdef __HAS_EDS__
+		p = malloc_stats_put_task(p, &tasks[i], MALLOC_HEAP_EDS, tasks[i].live_eds, tasks[i].peak_eds);
+#endif
+	}
+
+	return p - (uint8_t *)buf;
+}
+
+#ifdef __HAS_EDS__
+
+void malloc_stats_eds(malloc_heap_stats *st) {
+	uint32_t free_blocks = 0, largest = 0;
+	uint16_t entries = 0;
+
+	if (umm_eds_heap == NULL) {
+		umm_eds_init();
+	}
+
+	UMM_CRITICAL_ENTRY();
+
+	for (uint16_t b = UMM_EDS_NFREE(0); b; b = UMM_EDS_NFREE(b)) {
+		uint16_t n = (UMM_EDS_NBLOCK(b) & UMM_EDS_BLOCKNO_MASK) - b;
+
+		free_blocks += n;
+		entries++;
+
+		if (n > largest) {
+			largest = n;
+		}
+	}
+
+	UMM_CRITICAL_EXIT();
+
+	malloc_stats_fill(st, MALLOC_HEAP_EDS, UMM_EDSHeap_Size, free_blocks * sizeof(umm_eds_block), largest * sizeof(umm_eds_block));
+	st->free_entries = entries;
+}
 
 auto_eds void *malloc_eds(uint32_t size) {
-	return umm_eds_malloc(size);
+	auto_eds void *ret = umm_eds_malloc(size);
+
+	malloc_stats_request(MALLOC_HEAP_EDS, size, ret || !size);
+
+	if (ret) {
+		malloc_stats_account(MALLOC_HEAP_EDS, (int32_t)umm_eds_ptr_blocks(ret) * (int32_t)sizeof(umm_eds_block));
+	}
+
+	return ret;
 }
 
 auto_eds void *calloc_eds(uint32_t num, uint32_t size) {
-	return umm_eds_calloc(num, size);
+	auto_eds void *ret = malloc_eds(num * size);
+
+	if (ret) {
+		memset_eds(ret, 0, num * size);
+	}
+
+	return ret;
 }
 
 auto_eds void *realloc_eds(auto_eds void *ptr, uint32_t size) {
-	return umm_eds_realloc(ptr, size);
+	int32_t old_bytes = ptr ? (int32_t)umm_eds_ptr_blocks(ptr) * (int32_t)sizeof(umm_eds_block) : 0;
+
+	auto_eds void *ret = umm_eds_realloc(ptr, size);
+
+	if (size) {
+		malloc_stats_request(MALLOC_HEAP_EDS, size, ret != NULL);
+	}
+
+	if (ret) {
+		malloc_stats_account(MALLOC_HEAP_EDS, (int32_t)umm_eds_ptr_blocks(ret) * (int32_t)sizeof(umm_eds_block) - old_bytes);
+	} else if (!size) {
+		malloc_stats_account(MALLOC_HEAP_EDS, -old_bytes);
+	}
+
+	return ret;
 }
 
 void free_eds(auto_eds void *ptr) {
+	if (!ptr) {
+		return;
+	}
+
+	malloc_stats_account(MALLOC_HEAP_EDS, -(int32_t)umm_eds_ptr_blocks(ptr) * (int32_t)sizeof(umm_eds_block));
+
 	umm_eds_free(ptr);
 }
 
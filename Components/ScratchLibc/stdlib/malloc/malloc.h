@@ -33,8 +33,87 @@ extern void free_eds(auto_eds void *ptr);
 
 #endif
 
+/*
+ * Small allocations (up to 256 bytes) are rounded up to a size class, and
+ * freed blocks are kept on per class free lists, up to MALLOC_CACHE_DEPTH
+ * blocks per class, so that they can be handed out again in O(1) without
+ * searching the umm free list. Set MALLOC_CACHE_DEPTH to 0 to disable.
+ */
+
+#ifndef MALLOC_CACHE_DEPTH
+#define MALLOC_CACHE_DEPTH	8
+#endif
+
+#define MALLOC_CACHE_CLASSES	6
+
+typedef struct {
+	uint16_t size;
+	uint16_t cached;
+	uint16_t hits;
+	uint16_t misses;
+} malloc_cache_class_info;
+
 extern void *malloc(size_t size);
 extern void *calloc(size_t num, size_t size);
 extern void *realloc(void *ptr, size_t size);
 extern void free(void *ptr);
 
+extern int malloc_trim(size_t pad);
+extern void malloc_cache_info(malloc_cache_class_info info[MALLOC_CACHE_CLASSES]);
+
+
+/*
+ * Heap telemetry. malloc()/free() and friends keep a few cheap counters
+ * (live bytes, peak, request size histogram, failures, live bytes per task),
+ * malloc_stats() adds a walk of the free list for the free/largest/
+ * fragmentation figures. Sizes are in bytes of umm blocks, so they include
+ * the block headers and rounding.
+ *
+ * Bytes are charged to the task calling malloc() and credited to the task
+ * calling free(), so a task that frees memory allocated by another one can
+ * go negative. Allocations made before the scheduler starts, and by tasks
+ * that don't fit in the table, are charged to the entry with task == NULL.
+ */
+
+#ifndef MALLOC_STATS_TASKS
+#define MALLOC_STATS_TASKS	8
+#endif
+
+// Request sizes: <= 8, 16, 32, 64, 128, 256, 512, and larger
+#define MALLOC_STATS_HIST_BINS	8
+
+#define MALLOC_HEAP_NEAR	0
+#define MALLOC_HEAP_EDS		1
+
+typedef struct {
+	uint32_t total;
+	uint32_t used;
+	uint32_t free;
+	uint32_t largest_free;
+	uint32_t live;
+	uint32_t peak;
+	uint16_t free_entries;
+	uint16_t failures;
+	uint8_t heap;
+	uint8_t fragmentation;	// 0 - 100
+	uint16_t alloc_hist[MALLOC_STATS_HIST_BINS];
+} malloc_heap_stats;
+
+typedef struct {
+	void *task;
+	int32_t live;
+	uint32_t peak;
+#ifdef __HAS_EDS__
+	int32_t live_eds;
+	uint32_t peak_eds;
+#endif
+} malloc_task_stats;
+
+extern void malloc_stats(malloc_heap_stats *st);
+extern uint8_t malloc_task_stats_get(malloc_task_stats *st, uint8_t max);
+extern void malloc_stats_reset_peak(void);
+extern size_t malloc_stats_export(void *buf, size_t len);
+
+#ifdef __HAS_EDS__
+extern void malloc_stats_eds(malloc_heap_stats *st);
+#endif
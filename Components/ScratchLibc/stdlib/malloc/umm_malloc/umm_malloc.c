@@ -300,6 +300,7 @@ void umm_free(void *ptr) {
 
 	umm_free_core(ptr);
 
+	UMM_HEAP_CHANGED();
 	UMM_CRITICAL_EXIT();
 }
 
@@ -442,6 +443,7 @@ void *umm_malloc(size_t size) {
 
 	ptr = umm_malloc_core(size);
 
+	UMM_HEAP_CHANGED();
 	UMM_CRITICAL_EXIT();
 
 	return ptr;
@@ -633,6 +635,7 @@ void *umm_realloc(void *ptr, size_t size) {
 	}
 
 	/* Release the critical section... */
+	UMM_HEAP_CHANGED();
 	UMM_CRITICAL_EXIT();
 
 	return ptr;
@@ -640,6 +643,24 @@ void *umm_realloc(void *ptr, size_t size) {
 
 /* ------------------------------------------------------------------------ */
 
+/*
+ * Number of blocks an allocation of `size` bytes takes, and number of blocks
+ * taken by the allocation at `ptr`. Used by the size class cache in malloc.c
+ * to find out which class a freed pointer belongs to.
+ */
+
+uint16_t umm_size_to_blocks(size_t size) {
+	return umm_blocks(size);
+}
+
+uint16_t umm_ptr_blocks(void *ptr) {
+	uint16_t c = (((void *)ptr) - (void *)(&(umm_heap[0]))) / sizeof(umm_block);
+
+	return (UMM_NBLOCK(c) & UMM_BLOCKNO_MASK) - c;
+}
+
+/* ------------------------------------------------------------------------ */
+
 void *umm_calloc(size_t num, size_t item_size) {
 	void *ret;
 
@@ -69,6 +69,9 @@ extern void *umm_calloc(size_t num, size_t size);
 extern void *umm_realloc(void *ptr, size_t size);
 extern void  umm_free(void *ptr);
 
+extern uint16_t umm_size_to_blocks(size_t size);
+extern uint16_t umm_ptr_blocks(void *ptr);
+
 /* ------------------------------------------------------------------------ */
 
 #ifdef __cplusplus
@@ -15,6 +15,8 @@
 #include <FreeRTOS/FreeRTOS.h>
 #include <FreeRTOS/task.h>
 
+#include <PICo24/Core/Latency.h>
+
 
 #define UMM_INTEGRITY_CHECK
 
@@ -179,8 +181,8 @@ extern int umm_max_critical_depth;
     #define UMM_CRITICAL_EXIT()  (umm_critical_depth--)
 #else
 #ifdef PICo24_FreeRTOS_Enabled
-#define UMM_CRITICAL_ENTRY() taskENTER_CRITICAL()
-#define UMM_CRITICAL_EXIT() taskEXIT_CRITICAL()
+#define UMM_CRITICAL_ENTRY() do { taskENTER_CRITICAL(); PICo24_LATENCY_ENTER(LATENCY_HEAP); } while (0)
+#define UMM_CRITICAL_EXIT() do { PICo24_LATENCY_EXIT(LATENCY_HEAP); taskEXIT_CRITICAL(); } while (0)
 #else
 #define UMM_CRITICAL_ENTRY()
 #define UMM_CRITICAL_EXIT()
@@ -208,6 +210,36 @@ extern void umm_corruption(void);
 #define INTEGRITY_CHECK() (1)
 #endif
 
+/*
+ * umm_integrity_check() walks the whole heap inside a critical section, so
+ * it's never called implicitly. Instead, umm_integrity_step() checks a bounded
+ * number of blocks per call and resumes on the next one. Whenever the idle
+ * hook runs, it calls umm_integrity_step(UMM_INTEGRITY_IDLE_STEP_BLOCKS);
+ * set it to 0 to disable that.
+ *
+ * For debug builds, define UMM_INTEGRITY_CHECK_EVERY_N to N > 0 to also run
+ * the full umm_integrity_check() on every Nth malloc/free/realloc.
+ */
+
+#ifndef UMM_INTEGRITY_IDLE_STEP_BLOCKS
+#define UMM_INTEGRITY_IDLE_STEP_BLOCKS 16
+#endif
+
+#ifndef UMM_INTEGRITY_CHECK_EVERY_N
+#define UMM_INTEGRITY_CHECK_EVERY_N 0
+#endif
+
+extern uint16_t umm_heap_generation;
+extern uint16_t umm_integrity_passes;
+extern bool umm_integrity_step(uint16_t max_blocks);
+
+#if UMM_INTEGRITY_CHECK_EVERY_N
+extern void umm_integrity_sample(void);
+#define UMM_HEAP_CHANGED() do { umm_heap_generation++; umm_integrity_sample(); } while (0)
+#else
+#define UMM_HEAP_CHANGED() do { umm_heap_generation++; } while (0)
+#endif
+
 /*
  * Enables heap poisoning: add predefined value (poison) before and after each
  * allocation, and check before each heap operation that no poison is
@@ -132,4 +132,122 @@ clean:
 
 /* }}} */
 
+/*
+ * Incremental integrity check. Unlike umm_eds_integrity_check(), which needs the
+ * whole walk to happen in one critical section (it temporarily marks blocks),
+ * umm_eds_integrity_step() checks at most `max_blocks` blocks per call and only
+ * looks at the links around each block, so the time spent with interrupts
+ * masked is bounded regardless of the heap size. Call it periodically from a
+ * low priority task or from the idle hook.
+ *
+ * For every block it visits, it checks that the next block number is valid
+ * and increasing, that the next block links back to it, and for free blocks,
+ * that the neighbours in the free list link back as well.
+ *
+ * The walk resumes where the previous call stopped. If the heap has been
+ * modified in between, the saved position is only reused if it's still the
+ * head of a block, otherwise the walk restarts from block 0.
+ */
+
+uint16_t umm_eds_heap_generation = 0;
+uint16_t umm_eds_integrity_passes = 0;
+
+static uint16_t umm_eds_integrity_cursor = 0;
+static uint16_t umm_eds_integrity_generation = 0;
+
+static bool umm_eds_integrity_is_block_head(uint16_t c) {
+    uint16_t next = UMM_EDS_NBLOCK(c) & UMM_EDS_BLOCKNO_MASK;
+    uint16_t prev = UMM_EDS_PBLOCK(c) & UMM_EDS_BLOCKNO_MASK;
+
+    if (c >= UMM_EDS_NUMBLOCKS || next >= UMM_EDS_NUMBLOCKS || prev >= c) {
+        return false;
+    }
+
+    return (UMM_EDS_NBLOCK(prev) & UMM_EDS_BLOCKNO_MASK) == c &&
+           (next == 0 || (UMM_EDS_PBLOCK(next) & UMM_EDS_BLOCKNO_MASK) == c);
+}
+
+bool umm_eds_integrity_step(uint16_t max_blocks) {
+    bool ok = true;
+    uint16_t cur;
+
+    if (umm_eds_heap == NULL) {
+        umm_eds_init();
+    }
+
+    UMM_CRITICAL_ENTRY();
+
+    cur = umm_eds_integrity_cursor;
+
+    if (umm_eds_integrity_generation != umm_eds_heap_generation) {
+        umm_eds_integrity_generation = umm_eds_heap_generation;
+
+        if (cur && !umm_eds_integrity_is_block_head(cur)) {
+            cur = 0;
+        }
+    }
+
+    while (max_blocks--) {
+        uint16_t next = UMM_EDS_NBLOCK(cur) & UMM_EDS_BLOCKNO_MASK;
+
+        if (next >= UMM_EDS_NUMBLOCKS) {
+            UMM_LOG_CRITICAL("Heap integrity broken: too large next block num: %d "
+                "(in block %d)\n", next, cur);
+            ok = false;
+            break;
+        }
+
+        if (next == 0) {
+            /* Reached the last block, a full pass is done */
+            umm_eds_integrity_passes++;
+            cur = 0;
+            break;
+        }
+
+        if (next <= cur || (UMM_EDS_PBLOCK(next) & UMM_EDS_BLOCKNO_MASK) != cur) {
+            UMM_LOG_CRITICAL("Heap integrity broken: block links don't match: "
+                "%d -> %d, but %d -> %d\n", cur, next, next, UMM_EDS_PBLOCK(next));
+            ok = false;
+            break;
+        }
+
+        if (UMM_EDS_NBLOCK(next) & UMM_FREELIST_MASK) {
+            uint16_t nfree = UMM_EDS_NFREE(next);
+            uint16_t pfree = UMM_EDS_PFREE(next);
+
+            if (nfree >= UMM_EDS_NUMBLOCKS || pfree >= UMM_EDS_NUMBLOCKS ||
+                (nfree && UMM_EDS_PFREE(nfree) != next) || UMM_EDS_NFREE(pfree) != next) {
+                UMM_LOG_CRITICAL("Heap integrity broken: free links don't match "
+                    "around block %d: prev %d, next %d\n", next, pfree, nfree);
+                ok = false;
+                break;
+            }
+        }
+
+        cur = next;
+    }
+
+    umm_eds_integrity_cursor = ok ? cur : 0;
+
+    UMM_CRITICAL_EXIT();
+
+    if (!ok) {
+        UMM_HEAP_CORRUPTION_CB();
+    }
+
+    return ok;
+}
+
+#if UMM_EDS_INTEGRITY_CHECK_EVERY_N
+/* Must be called from within the allocator's critical section */
+void umm_eds_integrity_sample(void) {
+    static uint16_t calls = 0;
+
+    if (++calls >= UMM_EDS_INTEGRITY_CHECK_EVERY_N) {
+        calls = 0;
+        umm_eds_integrity_check();
+    }
+}
+#endif
+
 #endif
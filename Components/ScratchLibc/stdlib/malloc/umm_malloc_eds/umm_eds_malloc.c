@@ -302,6 +302,7 @@ void umm_eds_free(auto_eds void *ptr) {
 
 	umm_eds_free_core(ptr);
 
+	UMM_EDS_HEAP_CHANGED();
 	UMM_CRITICAL_EXIT();
 }
 
@@ -444,6 +445,7 @@ auto_eds void *umm_eds_malloc(uint32_t size) {
 
 	ptr = umm_eds_malloc_core(size);
 
+	UMM_EDS_HEAP_CHANGED();
 	UMM_CRITICAL_EXIT();
 
 	return ptr;
@@ -635,6 +637,7 @@ auto_eds void *umm_eds_realloc(auto_eds void *ptr, uint32_t size) {
 	}
 
 	/* Release the critical section... */
+	UMM_EDS_HEAP_CHANGED();
 	UMM_CRITICAL_EXIT();
 
 	return ptr;
@@ -656,4 +659,12 @@ auto_eds void *umm_eds_calloc(uint32_t num, uint32_t item_size) {
 
 /* ------------------------------------------------------------------------ */
 
+uint16_t umm_eds_ptr_blocks(auto_eds void *ptr) {
+	uint16_t c = (((auto_eds void *)ptr) - (auto_eds void *)(&(umm_eds_heap[0]))) / sizeof(umm_eds_block);
+
+	return (UMM_EDS_NBLOCK(c) & UMM_EDS_BLOCKNO_MASK) - c;
+}
+
+/* ------------------------------------------------------------------------ */
+
 #endif
@@ -68,6 +68,8 @@ extern auto_eds void *umm_eds_calloc(uint32_t num, uint32_t size);
 extern auto_eds void *umm_eds_realloc(auto_eds void *ptr, uint32_t size);
 extern void umm_eds_free(auto_eds void *ptr);
 
+extern uint16_t umm_eds_ptr_blocks(auto_eds void *ptr);
+
 /* ------------------------------------------------------------------------ */
 
 #ifdef __cplusplus
@@ -19,6 +19,8 @@
 #include <FreeRTOS/FreeRTOS.h>
 #include <FreeRTOS/task.h>
 
+#include <PICo24/Core/Latency.h>
+
 
 #define UMM_INTEGRITY_CHECK
 
@@ -172,8 +174,8 @@ extern void umm_eds_info(UMM_EDS_HEAP_INFO *ummHeapInfo);
  */
 
 
-#define UMM_CRITICAL_ENTRY() taskENTER_CRITICAL()
-#define UMM_CRITICAL_EXIT() taskEXIT_CRITICAL()
+#define UMM_CRITICAL_ENTRY() do { taskENTER_CRITICAL(); PICo24_LATENCY_ENTER(LATENCY_HEAP); } while (0)
+#define UMM_CRITICAL_EXIT() do { PICo24_LATENCY_EXIT(LATENCY_HEAP); taskEXIT_CRITICAL(); } while (0)
 
 /*
  * Enables heap integrity check before any heap operation. It affects
@@ -196,6 +198,28 @@ extern void umm_corruption(void);
 #define INTEGRITY_CHECK() (1)
 #endif
 
+/* See umm_malloc_cfg.h, these are the EDS heap counterparts */
+
+#ifndef UMM_EDS_INTEGRITY_IDLE_STEP_BLOCKS
+#define UMM_EDS_INTEGRITY_IDLE_STEP_BLOCKS 16
+#endif
+
+#ifndef UMM_EDS_INTEGRITY_CHECK_EVERY_N
+#define UMM_EDS_INTEGRITY_CHECK_EVERY_N 0
+#endif
+
+extern bool umm_eds_integrity_check(void);
+extern uint16_t umm_eds_heap_generation;
+extern uint16_t umm_eds_integrity_passes;
+extern bool umm_eds_integrity_step(uint16_t max_blocks);
+
+#if UMM_EDS_INTEGRITY_CHECK_EVERY_N
+extern void umm_eds_integrity_sample(void);
+#define UMM_EDS_HEAP_CHANGED() do { umm_eds_heap_generation++; umm_eds_integrity_sample(); } while (0)
+#else
+#define UMM_EDS_HEAP_CHANGED() do { umm_eds_heap_generation++; } while (0)
+#endif
+
 /*
  * Add blank macros for DBGLOG_xxx() - if you want to override these on
  * a per-source module basis, you must define DBGLOG_LEVEL and then
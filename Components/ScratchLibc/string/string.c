@@ -20,38 +20,247 @@
 #include "string.h"
 
 #ifdef __HAS_EDS__
+
+#include <xc.h>
+
+// An EDS pointer is {page, offset}. Offsets below 0x8000 are plain near RAM, offsets at or above 0x8000
+// go through the 32KB window selected by DSRPAG (reads) and DSWPAG (writes).
+// Dereferencing an __eds__ pointer makes the compiler reload the page register on every access, so the
+// functions below split the buffers at page boundaries, set the page registers once per chunk, and then
+// work on near pointers into the window, a word at a time when both sides are word aligned.
+
+#define EDS_PAGE(p)		__builtin_edspage(p)
+#define EDS_OFFSET(p)		__builtin_edsoffset(p)
+#define EDS_IN_WINDOW(off)	((off) & 0x8000U)
+#define EDS_NEAR(off)		((uint8_t *)(off))
+
+// Bytes from p to the end of its page, at most `len'
+static inline uint16_t eds_chunk_fwd(auto_eds const void *p, uint32_t len) {
+	uint16_t till = 0x8000U - (EDS_OFFSET(p) & 0x7fffU);
+	return len < till ? (uint16_t)len : till;
+}
+
+// Bytes from the start of the page of (end - 1) to end, at most `len'
+static inline uint16_t eds_chunk_back(auto_eds const void *end, uint32_t len) {
+	uint16_t till = (EDS_OFFSET((auto_eds const uint8_t *)end - 1) & 0x7fffU) + 1;
+	return len < till ? (uint16_t)len : till;
+}
+
+static inline void eds_set_rpag(uint16_t off, uint16_t page) {
+	if (EDS_IN_WINDOW(off)) {
+		DSRPAG = page;
+	}
+}
+
+static inline void eds_set_wpag(uint16_t off, uint16_t page) {
+	if (EDS_IN_WINDOW(off)) {
+		DSWPAG = page;
+	}
+}
+
+static void near_copy_fwd(uint8_t *d, const uint8_t *s, uint16_t n) {
+	if (!(((uint16_t)d | (uint16_t)s) & 1)) {
+		uint16_t *dw = (uint16_t *)d;
+		const uint16_t *sw = (const uint16_t *)s;
+
+		for (uint16_t i=n>>1; i; i--) {
+			*dw++ = *sw++;
+		}
+
+		d = (uint8_t *)dw;
+		s = (const uint8_t *)sw;
+		n &= 1;
+	}
+
+	while (n--) {
+		*d++ = *s++;
+	}
+}
+
+// d and s point one past the end
+static void near_copy_back(uint8_t *d, const uint8_t *s, uint16_t n) {
+	if (!(((uint16_t)d | (uint16_t)s) & 1)) {
+		uint16_t *dw = (uint16_t *)d;
+		const uint16_t *sw = (const uint16_t *)s;
+
+		for (uint16_t i=n>>1; i; i--) {
+			*--dw = *--sw;
+		}
+
+		d = (uint8_t *)dw;
+		s = (const uint8_t *)sw;
+		n &= 1;
+	}
+
+	while (n--) {
+		*--d = *--s;
+	}
+}
+
+static void near_fill(uint8_t *d, uint8_t c, uint16_t n) {
+	if (((uint16_t)d & 1) && n) {
+		*d++ = c;
+		n--;
+	}
+
+	uint16_t *dw = (uint16_t *)d;
+	uint16_t cw = c | ((uint16_t)c << 8);
+
+	for (uint16_t i=n>>1; i; i--) {
+		*dw++ = cw;
+	}
+
+	if (n & 1) {
+		*(uint8_t *)dw = c;
+	}
+}
+
+static int near_compare(const uint8_t *s1, const uint8_t *s2, uint16_t n) {
+	if (!(((uint16_t)s1 | (uint16_t)s2) & 1)) {
+		const uint16_t *w1 = (const uint16_t *)s1;
+		const uint16_t *w2 = (const uint16_t *)s2;
+		uint16_t i = n >> 1;
+
+		while (i && *w1 == *w2) {
+			w1++;
+			w2++;
+			i--;
+		}
+
+		// Let the byte loop below find the differing byte in the mismatched word
+		n = (i << 1) | (n & 1);
+		s1 = (const uint8_t *)w1;
+		s2 = (const uint8_t *)w2;
+	}
+
+	for (; n; n--, s1++, s2++) {
+		if (*s1 != *s2) {
+			return (int)*s1 - (int)*s2;
+		}
+	}
+
+	return 0;
+}
+
+bool (*memcpy_near_offload)(void *dest, const void *src, uint16_t len);
+
 auto_eds void *memset_eds(auto_eds void *p, int c, uint32_t len) {
-	for (uint32_t i=0; i<len; i++) {
-		((auto_eds uint8_t *)p)[i] = c;
+	auto_eds uint8_t *d = p;
+	uint16_t saved_wpag = DSWPAG;
+
+	while (len) {
+		uint16_t n = eds_chunk_fwd(d, len);
+		uint16_t off = EDS_OFFSET(d);
+
+		eds_set_wpag(off, EDS_PAGE(d));
+		near_fill(EDS_NEAR(off), c, n);
+
+		d += n;
+		len -= n;
 	}
 
+	DSWPAG = saved_wpag;
+
 	return p;
 }
 
 auto_eds void *memcpy_eds(auto_eds void *dest, auto_eds const void *src, uint32_t len) {
-	for (uint32_t i=0; i<len; i++) {
-		((auto_eds uint8_t *)dest)[i] = ((auto_eds uint8_t *)src)[i];
+	auto_eds uint8_t *d = dest;
+	auto_eds const uint8_t *s = src;
+	uint16_t saved_rpag = DSRPAG, saved_wpag = DSWPAG;
+
+	while (len) {
+		uint16_t n = eds_chunk_fwd(d, eds_chunk_fwd(s, len));
+		uint16_t doff = EDS_OFFSET(d), soff = EDS_OFFSET(s);
+
+		if (EDS_IN_WINDOW(doff | soff) || !memcpy_near_offload || !memcpy_near_offload(EDS_NEAR(doff), EDS_NEAR(soff), n)) {
+			eds_set_rpag(soff, EDS_PAGE(s));
+			eds_set_wpag(doff, EDS_PAGE(d));
+			near_copy_fwd(EDS_NEAR(doff), EDS_NEAR(soff), n);
+		}
+
+		d += n;
+		s += n;
+		len -= n;
 	}
 
+	DSRPAG = saved_rpag;
+	DSWPAG = saved_wpag;
+
 	return dest;
 }
 
 auto_eds void *memmove_eds(auto_eds void *dest, auto_eds const void *src, uint32_t len) {
-	for (uint32_t i=0; i<len; i++) {
-		uint8_t buf = ((auto_eds uint8_t *)src)[i];
-		((auto_eds uint8_t *)dest)[i] = buf;
+	auto_eds uint8_t *d = dest;
+	auto_eds const uint8_t *s = src;
+
+	// No overlap, or the destination is below the source: a forward copy never clobbers unread bytes
+	if (d <= s || d >= s + len) {
+		return memcpy_eds(dest, src, len);
+	}
+
+	uint16_t saved_rpag = DSRPAG, saved_wpag = DSWPAG;
+
+	d += len;
+	s += len;
+
+	while (len) {
+		uint16_t n = eds_chunk_back(d, eds_chunk_back(s, len));
+
+		d -= n;
+		s -= n;
+		len -= n;
+
+		uint16_t doff = EDS_OFFSET(d), soff = EDS_OFFSET(s);
+
+		eds_set_rpag(soff, EDS_PAGE(s));
+		eds_set_wpag(doff, EDS_PAGE(d));
+		near_copy_back(EDS_NEAR(doff) + n, EDS_NEAR(soff) + n, n);
 	}
 
+	DSRPAG = saved_rpag;
+	DSWPAG = saved_wpag;
+
 	return dest;
 }
 
 int memcmp_eds(auto_eds const void *s1, auto_eds const void *s2, uint32_t n) {
-	for (uint32_t i=0; i<n; i++) {
-		if (((auto_eds uint8_t *)s1)[i] != ((auto_eds uint8_t *)s2)[i]) {
-			return 1;
+	auto_eds const uint8_t *p1 = s1;
+	auto_eds const uint8_t *p2 = s2;
+	uint16_t saved_rpag = DSRPAG;
+	int ret = 0;
+
+	while (n && !ret) {
+		uint16_t len = eds_chunk_fwd(p1, eds_chunk_fwd(p2, n));
+		uint16_t off1 = EDS_OFFSET(p1), off2 = EDS_OFFSET(p2);
+		uint16_t page1 = EDS_PAGE(p1), page2 = EDS_PAGE(p2);
+
+		if (EDS_IN_WINDOW(off1) && EDS_IN_WINDOW(off2) && page1 != page2) {
+			// Both sides need DSRPAG, so bounce one side through a small near buffer
+			uint16_t bounce[16];
+
+			if (len > sizeof(bounce)) {
+				len = sizeof(bounce);
+			}
+
+			DSRPAG = page2;
+			near_copy_fwd((uint8_t *)bounce, EDS_NEAR(off2), len);
+			DSRPAG = page1;
+			ret = near_compare(EDS_NEAR(off1), (const uint8_t *)bounce, len);
+		} else {
+			eds_set_rpag(off1, page1);
+			eds_set_rpag(off2, page2);
+			ret = near_compare(EDS_NEAR(off1), EDS_NEAR(off2), len);
 		}
+
+		p1 += len;
+		p2 += len;
+		n -= len;
 	}
 
-	return 0;
+	DSRPAG = saved_rpag;
+
+	return ret;
 }
+
 #endif
@@ -21,6 +21,8 @@
 
 #include <PICo24/Core/IDESupport.h>
 
+#include <stdbool.h>
+
 #include "../inttypes/inttypes.h"
 
 #ifdef __HAS_EDS__
@@ -28,4 +30,7 @@ extern auto_eds void *memset_eds(auto_eds void *p, int c, uint32_t len);
 extern auto_eds void *memcpy_eds(auto_eds void *dest, auto_eds const void *src, uint32_t len);
 extern auto_eds void *memmove_eds(auto_eds void *dest, auto_eds const void *src, uint32_t len);
 extern int memcmp_eds(auto_eds const void *s1, auto_eds const void *s2, uint32_t n);
+
+// Optional faster copy for the parts of memcpy_eds() in near RAM, e.g. DMA_Memcpy(). Returns false to leave them to the CPU
+extern bool (*memcpy_near_offload)(void *dest, const void *src, uint16_t len);
 #endif
\ No newline at end of file
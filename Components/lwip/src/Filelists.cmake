@@ -58,7 +58,8 @@ set(lwipcore_SRCS
     ${LWIP_DIR}/src/core/tcp_out.c
     ${LWIP_DIR}/src/core/timeouts.c
     ${LWIP_DIR}/src/core/udp.c
-        ${LWIP_DIR}/src/core/sys_arch.c)
+        ${LWIP_DIR}/src/core/sys_arch.c
+        ${LWIP_DIR}/src/core/chksum_arch.c)
 
 set(lwipcore4_SRCS
     ${LWIP_DIR}/src/core/ipv4/acd.c
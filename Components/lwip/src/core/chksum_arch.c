@@ -0,0 +1,291 @@
+/*
+    This file is part of PICo24 SDK.
+
+    Copyright (C) 2021 ReimuNotMoe <reimu@sudomaker.com>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Internet checksum for the PIC24 port, see LWIP_CHKSUM and LWIP_CHKSUM_COPY
+ * in arch/cc.h.
+ *
+ * All of these return the same thing as lwip_standard_chksum(): the non
+ * inverted ones' complement sum of the data taken as little endian words
+ * starting from its first byte, regardless of the alignment. That makes the
+ * sums of consecutive even length pieces simply add up.
+ */
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#include <string.h>
+
+#ifdef __HAS_EDS__
+#include <ScratchLibc/ScratchLibc.h>
+#endif
+
+#define CHKSUM_EDS_BOUNCE_SIZE	64
+
+static inline u16_t chksum_fold(u32_t sum) {
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+	return (u16_t)sum;
+}
+
+// Sums `words` aligned words into `sum`, the result is not folded
+static inline u32_t chksum_words(const u16_t *p, u16_t words, u32_t sum) {
+#ifdef __XC16__
+	u16_t n = words >> 3;
+	u16_t acc = 0;
+
+	// 8 words per iteration, the carries are chained through addc and folded back at the end
+	if (n) {
+		__asm__ volatile (
+			"1:\n"
+			"	add	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], [%[p]++], %[acc]\n"
+			"	addc	%[acc], #0, %[acc]\n"
+			"	addc	%[acc], #0, %[acc]\n"
+			"	dec	%[n], %[n]\n"
+			"	bra	nz, 1b\n"
+			: [acc] "+r" (acc), [p] "+r" (p), [n] "+r" (n)
+			:
+			: "cc", "memory"
+		);
+
+		sum += acc;
+	}
+
+	words &= 7;
+#else
+	while (words >= 4) {
+		sum += p[0];
+		sum += p[1];
+		sum += p[2];
+		sum += p[3];
+		p += 4;
+		words -= 4;
+	}
+#endif
+
+	while (words--) {
+		sum += *p++;
+	}
+
+	return sum;
+}
+
+// Same as chksum_words(), but also copies the words to `dst`
+static inline u32_t chksum_copy_words(u16_t *dst, const u16_t *src, u16_t words, u32_t sum) {
+#ifdef __XC16__
+	u16_t n = words >> 2;
+	u16_t acc = 0, t;
+
+	// mov doesn't touch the carry, so the chain works across the copies too.
+	// Each pass starts with add, since dec leaves C set on the way round.
+	if (n) {
+		__asm__ volatile (
+			"1:\n"
+			"	mov	[%[src]++], %[t]\n"
+			"	mov	%[t], [%[dst]++]\n"
+			"	add	%[acc], %[t], %[acc]\n"
+			"	mov	[%[src]++], %[t]\n"
+			"	mov	%[t], [%[dst]++]\n"
+			"	addc	%[acc], %[t], %[acc]\n"
+			"	mov	[%[src]++], %[t]\n"
+			"	mov	%[t], [%[dst]++]\n"
+			"	addc	%[acc], %[t], %[acc]\n"
+			"	mov	[%[src]++], %[t]\n"
+			"	mov	%[t], [%[dst]++]\n"
+			"	addc	%[acc], %[t], %[acc]\n"
+			"	addc	%[acc], #0, %[acc]\n"
+			"	addc	%[acc], #0, %[acc]\n"
+			"	dec	%[n], %[n]\n"
+			"	bra	nz, 1b\n"
+			: [acc] "+r" (acc), [src] "+r" (src), [dst] "+r" (dst), [n] "+r" (n), [t] "=&r" (t)
+			:
+			: "cc", "memory"
+		);
+
+		sum += acc;
+	}
+
+	words &= 3;
+#endif
+
+	while (words--) {
+		u16_t w = *src++;
+		*dst++ = w;
+		sum += w;
+	}
+
+	return sum;
+}
+
+u16_t pic24_chksum(const void *dataptr, int len) {
+	const u8_t *pb = (const u8_t *)dataptr;
+	u32_t sum = 0;
+	u16_t t = 0;
+	int odd = ((mem_ptr_t)pb & 1);
+
+	if (len <= 0) {
+		return 0;
+	}
+
+	// Same trick as lwip_standard_chksum(): start the sum with the first byte
+	// in the high half, then swap the result
+	if (odd) {
+		((u8_t *)&t)[1] = *pb++;
+		len--;
+	}
+
+	sum = chksum_words((const u16_t *)(const void *)pb, len >> 1, sum);
+
+	if (len & 1) {
+		((u8_t *)&t)[0] = pb[len - 1];
+	}
+
+	sum += t;
+	sum = chksum_fold(sum);
+
+	if (odd) {
+		sum = SWAP_BYTES_IN_WORD(sum);
+	}
+
+	return (u16_t)sum;
+}
+
+u16_t pic24_chksum_copy(void *dst, const void *src, u16_t len) {
+	u8_t *db = (u8_t *)dst;
+	const u8_t *sb = (const u8_t *)src;
+	u32_t sum = 0;
+	u16_t t = 0;
+	int odd = ((mem_ptr_t)sb & 1);
+
+	// Words can only be moved as is if both sides are equally aligned
+	if (((mem_ptr_t)db ^ (mem_ptr_t)sb) & 1) {
+		MEMCPY(dst, src, len);
+		return pic24_chksum(dst, len);
+	}
+
+	if (!len) {
+		return 0;
+	}
+
+	if (odd) {
+		((u8_t *)&t)[1] = *db++ = *sb++;
+		len--;
+	}
+
+	sum = chksum_copy_words((u16_t *)(void *)db, (const u16_t *)(const void *)sb, len >> 1, sum);
+
+	if (len & 1) {
+		((u8_t *)&t)[0] = db[len - 1] = sb[len - 1];
+	}
+
+	sum += t;
+	sum = chksum_fold(sum);
+
+	if (odd) {
+		sum = SWAP_BYTES_IN_WORD(sum);
+	}
+
+	return (u16_t)sum;
+}
+
+#ifdef __HAS_EDS__
+
+// Bounced through the stack in even sized chunks, so the partial sums just add up
+u16_t pic24_chksum_eds(auto_eds const void *dataptr, u32_t len) {
+	u16_t buf[CHKSUM_EDS_BOUNCE_SIZE / 2];
+	auto_eds const u8_t *p = (auto_eds const u8_t *)dataptr;
+	u32_t sum = 0;
+
+	while (len) {
+		u16_t n = len > CHKSUM_EDS_BOUNCE_SIZE ? CHKSUM_EDS_BOUNCE_SIZE : len;
+
+		memcpy_eds((auto_eds void *)buf, p, n);
+		sum += pic24_chksum(buf, n);
+
+		p += n;
+		len -= n;
+	}
+
+	return chksum_fold(sum);
+}
+
+u16_t pic24_chksum_copy_eds(void *dst, auto_eds const void *src, u16_t len) {
+	memcpy_eds((auto_eds void *)dst, src, len);
+
+	return pic24_chksum(dst, len);
+}
+
+#endif
+
+#if LWIP_CHKSUM_ARCH_SELFTEST
+
+#define CHKSUM_SELFTEST_SIZE	96
+
+// Byte by byte reference, same result as lwip_standard_chksum()
+static u16_t chksum_reference(const u8_t *p, u16_t len) {
+	u32_t sum = 0;
+	u16_t i;
+
+	for (i = 0; i < len; i++) {
+		sum += (i & 1) ? ((u16_t)p[i] << 8) : p[i];
+	}
+
+	return chksum_fold(sum);
+}
+
+// Runs both asm paths over every length and alignment up to
+// CHKSUM_SELFTEST_SIZE bytes, returns the number of mismatches
+int pic24_chksum_selftest(void) {
+	static u8_t src[CHKSUM_SELFTEST_SIZE + 2], dst[CHKSUM_SELFTEST_SIZE + 2];
+	int errors = 0;
+	u16_t i, off, len;
+
+	// Words near 0xffff, so that every addc carries
+	for (i = 0; i < sizeof(src); i++) {
+		src[i] = (i % 7) ? 0xff : (u8_t)(i * 37);
+	}
+
+	for (off = 0; off < 2; off++) {
+		for (len = 0; len <= CHKSUM_SELFTEST_SIZE; len++) {
+			u16_t ref = chksum_reference(src + off, len);
+
+			if (pic24_chksum(src + off, len) != ref) {
+				errors++;
+			}
+
+			memset(dst, 0, sizeof(dst));
+
+			if (pic24_chksum_copy(dst + off, src + off, len) != ref || memcmp(dst + off, src + off, len)) {
+				errors++;
+			}
+		}
+	}
+
+	return errors;
+}
+
+#endif
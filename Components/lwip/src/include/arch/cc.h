@@ -59,4 +59,23 @@
 
 #define	LWIP_RAND()			rand()
 
+#include <stdint.h>
+#include <PICo24/Core/IDESupport.h>
+
+// See core/chksum_arch.c
+#define	LWIP_CHKSUM			pic24_chksum
+#define	LWIP_CHKSUM_COPY(dst, src, len)	pic24_chksum_copy(dst, src, len)
+
+extern uint16_t pic24_chksum(const void *dataptr, int len);
+extern uint16_t pic24_chksum_copy(void *dst, const void *src, uint16_t len);
+
+#if LWIP_CHKSUM_ARCH_SELFTEST
+extern int pic24_chksum_selftest(void);
+#endif
+
+#ifdef __HAS_EDS__
+extern uint16_t pic24_chksum_eds(auto_eds const void *dataptr, uint32_t len);
+extern uint16_t pic24_chksum_copy_eds(void *dst, auto_eds const void *src, uint16_t len);
+#endif
+
 #endif /* LWIP_ARCH_CC_H */
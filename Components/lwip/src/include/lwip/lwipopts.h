@@ -46,7 +46,10 @@
 #define LWIP_FREERTOS_CHECK_CORE_LOCKING		1
 
 #define TCPIP_THREAD_PRIO				5
+// In words, see PICo24/Core/StackAudit.h before lowering it
+#ifndef TCPIP_THREAD_STACKSIZE
 #define TCPIP_THREAD_STACKSIZE				1024
+#endif
 #define TCPIP_MBOX_SIZE					2
 #define DEFAULT_ACCEPTMBOX_SIZE				1
 #define DEFAULT_TCP_RECVMBOX_SIZE			1
@@ -242,6 +245,14 @@ a lot of data that needs to be copied, this should be set high. */
 /* Maximum number of retransmissions of SYN segments. */
 #define TCP_SYNMAXRTX           4
 
+/* Calculate the checksum while copying data into pbufs (see
+   LWIP_CHKSUM_COPY in arch/cc.h), saves a second pass over TX data. */
+#define LWIP_CHECKSUM_ON_COPY   1
+
+/* Build pic24_chksum_selftest(), which checks the asm checksum loops
+   against a plain C sum on the target (see core/chksum_arch.c). */
+#define LWIP_CHKSUM_ARCH_SELFTEST   0
+
 
 /* ---------- ARP options ---------- */
 #define LWIP_ARP                1
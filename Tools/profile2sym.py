@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+#
+# This file is part of PICo24 SDK.
+#
+# Maps a PICo24 sampling profiler export (see
+# Components/PICo24/Core/Profiler.h) to functions, using the symbol table of
+# the ELF it was taken from.
+#
+# Usage: profile2sym.py app.elf capture.txt [--tasks] [--pcs] [--top N]
+#
+# --tasks also breaks every function down by task, --pcs lists the hottest
+# individual addresses. The capture may contain other console output, only
+# the lines between PROFILE and END are used.
+
+import bisect
+import struct
+import sys
+
+SHF_EXECINSTR = 0x4
+STT_SECTION = 3
+STT_FILE = 4
+
+
+def elf_functions(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if data[:4] != b'\x7fELF' or data[4] != 1:
+        raise ValueError('%s: not a 32-bit ELF' % path)
+
+    e_shoff, = struct.unpack_from('<I', data, 0x20)
+    e_shentsize, e_shnum = struct.unpack_from('<HH', data, 0x2e)
+
+    sections = [struct.unpack_from('<IIIIIIIIII', data, e_shoff + i * e_shentsize) for i in range(e_shnum)]
+    symbols = []
+
+    for name, stype, flags, addr, offset, size, link, info, align, entsize in sections:
+        if stype != 2:  # SHT_SYMTAB
+            continue
+
+        strtab = sections[link]
+
+        for off in range(offset, offset + size, entsize or 16):
+            st_name, st_value, st_size, st_info, st_other, st_shndx = struct.unpack_from('<IIIBBH', data, off)
+
+            if st_info & 0xf in (STT_SECTION, STT_FILE) or not 0 < st_shndx < len(sections):
+                continue
+
+            # Only symbols in code
+            if not sections[st_shndx][2] & SHF_EXECINSTR:
+                continue
+
+            start = strtab[4] + st_name
+            sym = data[start:data.index(b'\0', start)].decode(errors='replace')
+
+            if sym and not sym.startswith('.L'):
+                symbols.append((st_value, st_size, sym))
+
+    symbols.sort()
+
+    return symbols
+
+
+class Symbolizer:
+    def __init__(self, symbols):
+        self.symbols = symbols
+        self.starts = [s[0] for s in symbols]
+
+    def lookup(self, pc):
+        i = bisect.bisect_right(self.starts, pc) - 1
+
+        if i < 0:
+            return '?'
+
+        start, size, name = self.symbols[i]
+
+        # Assembly symbols often have no size, then it runs up to the next one
+        if size and pc >= start + size:
+            return '?'
+
+        return name
+
+
+def parse_capture(path):
+    header = None
+    samples = []
+    tasks = {}
+
+    with open(path, errors='replace') as f:
+        for line in f:
+            w = line.split()
+
+            if not w:
+                continue
+
+            if w[0] == 'PROFILE' and len(w) == 5:
+                header = [int(x) for x in w[1:]]
+                samples = []
+                tasks = {}
+            elif header is None:
+                continue
+            elif w[0] == 'P' and len(w) == 4:
+                samples.append((int(w[1], 16), int(w[2], 16), int(w[3])))
+            elif w[0] == 'T' and len(w) >= 3:
+                tasks[int(w[1], 16)] = ' '.join(w[2:])
+            elif w[0] == 'END':
+                break
+
+    if header is None:
+        raise ValueError('%s: no PROFILE section' % path)
+
+    return header, samples, tasks
+
+
+def main(argv):
+    args = [a for a in argv[1:] if not a.startswith('--')]
+    top = 40
+
+    if '--top' in argv:
+        top = int(argv[argv.index('--top') + 1])
+        args.remove(argv[argv.index('--top') + 1])
+
+    if len(args) != 2:
+        sys.stderr.write('Usage: %s app.elf capture.txt [--tasks] [--pcs] [--top N]\n' % argv[0])
+        return 1
+
+    sym = Symbolizer(elf_functions(args[0]))
+    (fcy, rate, total, dropped), samples, tasks = parse_capture(args[1])
+    counted = sum(s[2] for s in samples) or 1
+
+    def task_name(t):
+        return tasks.get(t, 'no task' if not t else '0x%04x' % t)
+
+    funcs = {}
+    per_task = {}
+
+    for task, pc, count in samples:
+        name = sym.lookup(pc)
+        funcs[name] = funcs.get(name, 0) + count
+        per_task.setdefault(name, {})
+        per_task[name][task] = per_task[name].get(task, 0) + count
+
+    print('%u samples at %u Hz (%.1f s), %u dropped' % (total, rate, total / rate if rate else 0, dropped))
+    print()
+    print('%7s %8s  %s' % ('%', 'Samples', 'Function'))
+
+    for name, count in sorted(funcs.items(), key=lambda x: -x[1])[:top]:
+        print('%6.2f%% %8u  %s' % (100.0 * count / counted, count, name))
+
+        if '--tasks' in argv:
+            for task, n in sorted(per_task[name].items(), key=lambda x: -x[1]):
+                print('%7s %8u    %s' % ('', n, task_name(task)))
+
+    if '--pcs' in argv:
+        print()
+        print('%7s %8s  %-8s %s' % ('%', 'Samples', 'PC', 'Function'))
+
+        for task, pc, count in sorted(samples, key=lambda x: -x[2])[:top]:
+            print('%6.2f%% %8u  %06x   %s (%s)' % (100.0 * count / counted, count, pc, sym.lookup(pc), task_name(task)))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
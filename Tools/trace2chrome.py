@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+#
+# This file is part of PICo24 SDK.
+#
+# Converts a capture of the PICo24 event trace stream (see
+# Components/PICo24/Core/Trace.h) into Chrome trace JSON, for
+# chrome://tracing or https://ui.perfetto.dev
+#
+# Usage: trace2chrome.py capture.bin [out.json] [--events ids.txt]
+#
+# ids.txt maps application event ids to names, one "<id> <name>" per line,
+# ids in decimal or 0x hex.
+
+import json
+import struct
+import sys
+
+TRACE_EV_TASK_SWITCH = 1
+TRACE_EV_USB_TRANSFER = 2
+TRACE_EV_MALLOC = 3
+TRACE_EV_FREE = 4
+TRACE_EV_BEGIN = 5
+TRACE_EV_END = 6
+TRACE_EV_USER = 0x100
+
+RECORD = struct.Struct('<IHHI')
+NAME_LENGTH = 16
+
+HEAPS = {0: 'near', 1: 'eds'}
+
+
+def frames(data):
+    i = 0
+
+    while True:
+        i = data.find(b'PT', i)
+
+        if i < 0 or i + 5 > len(data):
+            return
+
+        ftype = chr(data[i + 2])
+        length = data[i + 3] | data[i + 4] << 8
+
+        # Resync on anything that doesn't look like a whole frame
+        if ftype not in 'INR' or i + 5 + length > len(data):
+            i += 1
+            continue
+
+        yield ftype, data[i + 5:i + 5 + length]
+        i += 5 + length
+
+
+def load_names(path):
+    names = {}
+
+    with open(path) as f:
+        for line in f:
+            line = line.split('#')[0].strip()
+
+            if line:
+                ev, name = line.split(None, 1)
+                names[int(ev, 0)] = name
+
+    return names
+
+
+def convert(data, user_names):
+    fcy = 16000000
+    tasks = {}
+    events = []
+    lost = 0
+
+    stamp_last = None
+    stamp_high = 0
+    current = None
+
+    def ts(stamp):
+        nonlocal stamp_last, stamp_high
+
+        # 32-bit cycle stamps, unwrap
+        if stamp_last is not None and stamp < stamp_last:
+            stamp_high += 1 << 32
+
+        stamp_last = stamp
+
+        return (stamp_high + stamp) * 1e6 / fcy
+
+    for ftype, payload in frames(data):
+        if ftype == 'I':
+            fcy, recorded, dropped = struct.unpack('<III', payload[:12])
+
+            if dropped > lost:
+                events.append({'name': '%u events lost' % (dropped - lost), 'ph': 'i', 's': 'g',
+                               'ts': ts(stamp_last) if stamp_last is not None else 0, 'pid': 1, 'tid': 0})
+                lost = dropped
+
+        elif ftype == 'N':
+            for j in range(0, len(payload) - NAME_LENGTH, NAME_LENGTH + 1):
+                name = payload[j + 1:j + 1 + NAME_LENGTH].split(b'\0')[0].decode(errors='replace')
+                # Nameless entries only pad the frame, keep the name of a deleted task for its old records
+                if name:
+                    tasks[payload[j]] = name
+
+        elif ftype == 'R':
+            for stamp, ev, arg0, arg1 in RECORD.iter_unpack(payload[:len(payload) - len(payload) % RECORD.size]):
+                t = ts(stamp)
+                tid = current if current is not None else 0
+
+                if ev == TRACE_EV_TASK_SWITCH:
+                    if current is not None:
+                        events.append({'ph': 'E', 'ts': t, 'pid': 1, 'tid': current})
+
+                    current = arg0
+                    events.append({'name': 'run', 'ph': 'B', 'ts': t, 'pid': 1, 'tid': current})
+                elif ev == TRACE_EV_USB_TRANSFER:
+                    events.append({'name': 'EP%u %s' % (arg0 >> 4, 'IN' if arg0 & 0x08 else 'OUT'), 'cat': 'usb',
+                                   'ph': 'i', 's': 't', 'ts': t, 'pid': 1, 'tid': tid,
+                                   'args': {'ustat': arg0, 'ping_pong': (arg0 >> 2) & 1}})
+                elif ev in (TRACE_EV_MALLOC, TRACE_EV_FREE):
+                    events.append({'name': 'malloc' if ev == TRACE_EV_MALLOC else 'free', 'cat': 'heap',
+                                   'ph': 'i', 's': 't', 'ts': t, 'pid': 1, 'tid': tid,
+                                   'args': {'heap': HEAPS.get(arg0, arg0), 'bytes': arg1}})
+                elif ev in (TRACE_EV_BEGIN, TRACE_EV_END):
+                    events.append({'name': user_names.get(TRACE_EV_USER + arg0, 'slice %u' % arg0), 'cat': 'user',
+                                   'ph': 'B' if ev == TRACE_EV_BEGIN else 'E', 'ts': t, 'pid': 1, 'tid': tid,
+                                   'args': {'arg1': arg1}})
+                else:
+                    events.append({'name': user_names.get(ev, 'event 0x%x' % ev), 'cat': 'user',
+                                   'ph': 'i', 's': 't', 'ts': t, 'pid': 1, 'tid': tid,
+                                   'args': {'arg0': arg0, 'arg1': arg1}})
+
+    if current is not None and stamp_last is not None:
+        events.append({'ph': 'E', 'ts': ts(stamp_last), 'pid': 1, 'tid': current})
+
+    meta = [{'name': 'process_name', 'ph': 'M', 'pid': 1, 'args': {'name': 'PICo24'}},
+            {'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': 0, 'args': {'name': '(no task)'}}]
+
+    for num, name in sorted(tasks.items()):
+        meta.append({'name': 'thread_name', 'ph': 'M', 'pid': 1, 'tid': num, 'args': {'name': name}})
+
+    return {'traceEvents': meta + events, 'displayTimeUnit': 'ns'}
+
+
+def main(argv):
+    args = [a for a in argv[1:] if not a.startswith('--')]
+    user_names = {}
+
+    if '--events' in argv:
+        user_names = load_names(argv[argv.index('--events') + 1])
+        args.remove(argv[argv.index('--events') + 1])
+
+    if not args:
+        sys.stderr.write('Usage: %s capture.bin [out.json] [--events ids.txt]\n' % argv[0])
+        return 1
+
+    with open(args[0], 'rb') as f:
+        trace = convert(f.read(), user_names)
+
+    if len(args) > 1:
+        with open(args[1], 'w') as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))